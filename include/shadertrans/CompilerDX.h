@@ -1,35 +1,96 @@
 #pragma once
 
 #include "shadertrans/ShaderStage.h"
+#include "shadertrans/HLSLOptions.h"
 
 #include <dxc/Support/Global.h>
 #include <dxc/Support/Unicode.h>
 #include <dxc/Support/WinIncludes.h>
 #include <dxc/dxcapi.h>
 
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <string>
+#include <functional>
+#include <atomic>
+
 namespace shadertrans
 {
 
 // code from https://github.com/microsoft/ShaderConductor
+//
+// dxcompiler is loaded on first use rather than at construction, so
+// GLSL-only code paths never map it. A missing dll makes IsAvailable()
+// return false; the accessors below throw in that case.
 class CompilerDX
 {
+private:
+    struct PoolEntry
+    {
+        CComPtr<IDxcLibrary> library;
+        CComPtr<IDxcCompiler> compiler;
+    };
+
+public:
+    // A library/compiler pair checked out of the pool, owned by one thread
+    // until the lease is destroyed.
+    class Lease
+    {
+    public:
+        Lease(CompilerDX* owner, PoolEntry* entry) : m_owner(owner), m_entry(entry) {}
+        Lease(Lease&& other) noexcept : m_owner(other.m_owner), m_entry(other.m_entry) { other.m_owner = nullptr; }
+        ~Lease() { if (m_owner) m_owner->Release(m_entry); }
+
+        Lease(const Lease&) = delete;
+        Lease& operator = (const Lease&) = delete;
+        Lease& operator = (Lease&&) = delete;
+
+        IDxcLibrary* Library() const { return m_entry->library; }
+        IDxcCompiler* Compiler() const { return m_entry->compiler; }
+
+    private:
+        CompilerDX* m_owner;
+        PoolEntry* m_entry;
+
+    }; // Lease
+
 public:
     CompilerDX();
     ~CompilerDX();
 
     static CompilerDX& Instance();
 
-    IDxcLibrary* Library() const { return m_library; }
+    bool IsAvailable();
+    const std::string& GetLoadError() const { return m_load_error; }
+
+    IDxcLibrary* Library();
+
+    IDxcCompiler* Compiler();
 
-    IDxcCompiler* Compiler() const { return m_compiler; }
+    CComPtr<IDxcLinker> CreateLinker();
 
-    CComPtr<IDxcLinker> CreateLinker() const;
+    bool LinkerSupport();
 
-    bool LinkerSupport() const { return m_linkerSupport; }
+    // Concurrent compiles each take their own instance pair from the pool.
+    // Acquire() blocks while all max_size pairs are in use. With lazy_growth
+    // the pairs are created on first demand, otherwise up front.
+    Lease Acquire();
+    void SetPoolSize(size_t max_size, bool lazy_growth = true);
 
     void Destroy();
     void Terminate();
 
+private:
+    void Load();
+    void CheckAvailable();
+    void InitDefaultInstances();
+
+    std::unique_ptr<PoolEntry> CreatePoolEntry() const;
+    void Release(PoolEntry* entry);
+
 private:
     HMODULE m_dxcompilerDll = nullptr;
     DxcCreateInstanceProc m_createInstanceFunc = nullptr;
@@ -37,12 +98,132 @@ private:
     CComPtr<IDxcLibrary> m_library;
     CComPtr<IDxcCompiler> m_compiler;
 
-    bool m_linkerSupport;
+    bool m_linkerSupport = false;
+
+    std::once_flag m_load_flag;
+    std::once_flag m_default_flag;
+    std::once_flag m_linker_flag;
+    std::string m_load_error;
 
     bool m_dllDetaching = false;
 
+    std::mutex m_pool_mutex;
+    std::condition_variable m_pool_cond;
+    std::vector<std::unique_ptr<PoolEntry>> m_pool;
+    std::vector<PoolEntry*> m_pool_free;
+    size_t m_pool_max = 1;
+
 }; // CompilerDX
 
+// IDxcCompiler::Compile() arguments and defines for a set of options,
+// owning the wide strings they point to.
+class DxcArguments
+{
+public:
+    DxcArguments(const HLSLOptions& options);
+
+    const std::vector<const wchar_t*>& Args() const { return m_args; }
+    const std::vector<DxcDefine>& Defines() const { return m_defines; }
+
+private:
+    const wchar_t* Store(const std::string& utf8);
+    const wchar_t* Store(std::wstring str);
+
+private:
+    // deque elements never move, so the pointers below stay valid
+    std::deque<std::wstring> m_strings;
+
+    std::vector<const wchar_t*> m_args;
+    std::vector<DxcDefine> m_defines;
+
+}; // DxcArguments
+
+// include file contents for ScIncludeHandler, also from ShaderConductor
+class Blob
+{
+public:
+    Blob(const void* data, uint32_t size)
+        : data_(reinterpret_cast<const uint8_t*>(data), reinterpret_cast<const uint8_t*>(data) + size)
+    {
+    }
+
+    const void* Data() const
+    {
+        return data_.data();
+    }
+
+    uint32_t Size() const
+    {
+        return static_cast<uint32_t>(data_.size());
+    }
+
+private:
+    std::vector<uint8_t> data_;
+
+}; // Blob
+
+Blob* CreateBlob(const void* data, uint32_t size);
+void DestroyBlob(Blob* blob);
+
+// IDxcIncludeHandler that reads includes through loadCallback
+class ScIncludeHandler : public IDxcIncludeHandler
+{
+public:
+    ScIncludeHandler(IDxcLibrary* library, std::function<Blob*(const char* includeName)> loadCallback)
+        : m_library(library), m_loadCallback(std::move(loadCallback))
+    {
+    }
+
+    HRESULT STDMETHODCALLTYPE LoadSource(LPCWSTR fileName, IDxcBlob** includeSource) override;
+
+    ULONG STDMETHODCALLTYPE AddRef() override
+    {
+        ++m_ref;
+        return m_ref;
+    }
+
+    ULONG STDMETHODCALLTYPE Release() override
+    {
+        --m_ref;
+        ULONG result = m_ref;
+        if (result == 0)
+        {
+            delete this;
+        }
+        return result;
+    }
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, void** object) override
+    {
+        if (IsEqualIID(iid, __uuidof(IDxcIncludeHandler)))
+        {
+            *object = dynamic_cast<IDxcIncludeHandler*>(this);
+            this->AddRef();
+            return S_OK;
+        }
+        else if (IsEqualIID(iid, __uuidof(IUnknown)))
+        {
+            *object = dynamic_cast<IUnknown*>(this);
+            this->AddRef();
+            return S_OK;
+        }
+        else
+        {
+            return E_NOINTERFACE;
+        }
+    }
+
+private:
+    IDxcLibrary* m_library;
+    std::function<Blob*(const char* includeName)> m_loadCallback;
+
+    std::atomic<ULONG> m_ref = 0;
+
+}; // ScIncludeHandler
+
+// reads includeName relative to the working directory, throws if it can't
+Blob* DefaultLoadCallback(const char* includeName);
+
 std::wstring hlsl_shader_profile_name(ShaderStage stage, uint8_t major_ver, uint8_t minor_ver);
 
 }
\ No newline at end of file
@@ -4,15 +4,39 @@
 
 #include <glslang/public/ShaderLang.h>
 
+#include <mutex>
+#include <atomic>
+
 namespace shadertrans
 {
 
+// Owns glslang's process-wide state.
+//
+// Init() and Finalize() are serialized by one mutex, so glslang is never
+// initialized twice or torn down halfway, and Init() after Finalize()
+// initializes it again. A returned Init() only means glslang was up at that
+// moment: nothing keeps a later Finalize() from tearing it down, so the
+// caller must not run Finalize() while any thread may still compile. The
+// instance finalizes at exit.
+//
+// Thread safety guarantee: once Init() has returned, ShaderTrans::GLSL2SpirV,
+// ShaderParser::ParseHLSL and ShaderValidator::Validate may be called
+// concurrently from any number of threads. Each glslang::TShader/TProgram
+// carries its own pool allocator and binds it to the calling thread, so no
+// compile state is shared. GLSL2SpirV and ParseHLSL call Init() themselves,
+// ShaderValidator holds its own glslang reference while it has compilers.
+// Finalize() must not overlap a compile.
 class GLSLangAdapter
 {
 public:
 	void Init();
+	void Finalize();
+
+	bool IsInited() const { return m_inited; }
 
 	static EShLanguage Type2GLSLang(ShaderStage stage);
+	static void TargetEnv2GLSLang(TargetEnv env, glslang::EShTargetClientVersion& client,
+		glslang::EShTargetLanguageVersion& target);
 
 	static GLSLangAdapter* Instance();
 
@@ -21,9 +45,8 @@ private:
 	~GLSLangAdapter();
 
 private:
-	bool m_inited = false;
-
-	static GLSLangAdapter* m_instance;
+	std::mutex m_mutex;
+	std::atomic<bool> m_inited = false;
 
 }; // GLSLangAdapter
 
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "shadertrans/ShaderStage.h"
+#include "shadertrans/SpirvTools.h"
+
+#include <string>
+#include <vector>
+
+namespace shadertrans
+{
+
+// HLSL2SpirV settings, apart from ShaderTrans so that CompilerDX can build
+// dxc arguments from them without depending on ShaderTrans.
+struct HLSLOptions
+{
+	// dxc -O<n>, 0 to 3
+	int opt_level = 0;
+	// name and value, an empty value defines the name without one
+	std::vector<std::pair<std::string, std::string>> defines;
+	// -I, searched in order
+	std::vector<std::string> include_dirs;
+	// -fspv-target-env
+	TargetEnv target_env = TargetEnv::Vulkan_1_0;
+	// -fspv-reflect, keeps semantics and counter buffer links in the spirv
+	bool spv_reflect = false;
+	// passed to dxc as they are, e.g. "-enable-16bit-types"
+	std::vector<std::string> extra_args;
+
+	SpirvTools::OptimizeOptions optimize;
+};
+
+}
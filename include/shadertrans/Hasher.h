@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include <stdint.h>
+
+namespace shadertrans
+{
+
+// 64-bit FNV-1a
+class Hasher
+{
+public:
+	Hasher& Update(const void* data, size_t size)
+	{
+		auto bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < size; ++i) {
+			m_hash ^= bytes[i];
+			m_hash *= 0x100000001b3ull;
+		}
+		return *this;
+	}
+
+	Hasher& Update(std::string_view str)
+	{
+		// length first, so that ("ab", "c") and ("a", "bc") differ
+		Update(static_cast<uint64_t>(str.size()));
+		return Update(str.data(), str.size());
+	}
+
+	Hasher& Update(const std::string& str)
+	{
+		return Update(std::string_view(str));
+	}
+
+	Hasher& Update(const char* str)
+	{
+		return str ? Update(std::string(str)) : Update(uint64_t(-1));
+	}
+
+	Hasher& Update(uint64_t val) { return Update(&val, sizeof(val)); }
+	Hasher& Update(uint32_t val) { return Update(&val, sizeof(val)); }
+	Hasher& Update(bool val) { return Update(static_cast<uint32_t>(val)); }
+
+	uint64_t Digest() const { return m_hash; }
+
+private:
+	uint64_t m_hash = 0xcbf29ce484222325ull;
+
+}; // Hasher
+
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <filesystem>
+
+#include <stdint.h>
+
+namespace shadertrans
+{
+
+// Shared cache of shader include files, split at their #include lines.
+// Entries are checked against the file's mtime and size on every lookup,
+// so edited headers are picked up without clearing the cache.
+class IncludeCache
+{
+public:
+	struct Include
+	{
+		std::string path;
+		// <path>, skips the directory of the including file
+		bool system = false;
+	};
+
+	// text is chunks[0] includes[0] chunks[1] ... includes[n-1] chunks[n]
+	struct File
+	{
+		std::vector<std::string> chunks;
+		std::vector<Include> includes;
+
+		// #pragma once or an include guard around the whole file
+		bool once = false;
+
+		// Hasher over the whole text
+		uint64_t hash = 0;
+	};
+
+public:
+	static IncludeCache& Instance();
+
+	// nullptr if the file can't be read
+	std::shared_ptr<const File> Load(const std::string& filepath);
+
+	void Clear();
+
+	size_t GetHitCount() const { return m_hit_count; }
+	size_t GetMissCount() const { return m_miss_count; }
+
+	static std::shared_ptr<File> Parse(std::string_view text);
+
+private:
+	IncludeCache() {}
+
+private:
+	struct Entry
+	{
+		std::filesystem::file_time_type mtime;
+		uintmax_t size = 0;
+		std::shared_ptr<const File> file;
+	};
+
+	std::mutex m_mutex;
+	std::unordered_map<std::string, Entry> m_entries;
+
+	std::atomic<size_t> m_hit_count = 0;
+	std::atomic<size_t> m_miss_count = 0;
+
+}; // IncludeCache
+
+}
\ No newline at end of file
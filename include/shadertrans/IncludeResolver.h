@@ -0,0 +1,64 @@
+#pragma once
+
+#include "shadertrans/IncludeCache.h"
+
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include <iostream>
+
+namespace shadertrans
+{
+
+// Expands #include lines recursively. "path" is looked up next to the
+// including file, then in the search paths in order, then relative to the
+// working directory; <path> skips the first step. Files with #pragma once
+// or an include guard are expanded once, and cyclic includes are dropped.
+class IncludeResolver
+{
+public:
+	struct Dependency
+	{
+		std::string path;
+		// IncludeCache::File::hash of the contents
+		uint64_t hash = 0;
+	};
+
+public:
+	IncludeResolver(const std::vector<std::string>& search_paths = std::vector<std::string>());
+
+	// source_path is where source_code came from, if anywhere
+	std::string Resolve(std::string_view source_code, const std::string& source_path = "");
+
+	// full path of the include, empty if not found
+	std::string Find(const IncludeCache::Include& include, const std::string& from_dir) const;
+
+	// every file the last Resolve read, the source first if it had a path,
+	// includes in the order they were first reached
+	const std::vector<Dependency>& GetDependencies() const { return m_deps; }
+
+	// false once any file is gone or its contents changed
+	static bool IsUpToDate(const std::vector<Dependency>& deps);
+
+	// make/ninja depfile, "target: dep dep ..."
+	static void WriteDepfile(std::ostream& out, const std::string& target,
+		const std::vector<Dependency>& deps);
+	static bool WriteDepfile(const std::string& filepath, const std::string& target,
+		const std::vector<Dependency>& deps);
+
+private:
+	void Expand(const IncludeCache::File& file, const std::string& dir, std::string& out);
+
+private:
+	std::vector<std::string> m_search_paths;
+
+	// per Resolve call
+	std::unordered_set<std::string> m_once;
+	std::vector<std::string> m_stack;
+
+	std::vector<Dependency> m_deps;
+	std::unordered_set<std::string> m_dep_paths;
+
+}; // IncludeResolver
+
+}
\ No newline at end of file
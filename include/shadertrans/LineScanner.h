@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string_view>
+
+namespace shadertrans
+{
+
+// Walks a text line by line without copying, lines are views into it.
+// Same splitting as std::getline: '\n' separates, a trailing '\r' stays,
+// and a final newline doesn't start another line.
+class LineScanner
+{
+public:
+	LineScanner(std::string_view str) : m_str(str) {}
+
+	bool Next(std::string_view& line)
+	{
+		if (m_pos >= m_str.size()) {
+			return false;
+		}
+
+		auto end = m_str.find('\n', m_pos);
+		if (end == std::string_view::npos) {
+			end = m_str.size();
+		}
+		line = m_str.substr(m_pos, end - m_pos);
+		m_pos = end + 1;
+		return true;
+	}
+
+	static std::string_view Trim(std::string_view str)
+	{
+		const char* ws = " \t\r";
+		auto start = str.find_first_not_of(ws);
+		if (start == std::string_view::npos) {
+			return std::string_view();
+		}
+		auto end = str.find_last_not_of(ws);
+		return str.substr(start, end - start + 1);
+	}
+
+	static bool StartsWith(std::string_view str, std::string_view prefix)
+	{
+		return str.substr(0, prefix.size()) == prefix;
+	}
+
+private:
+	std::string_view m_str;
+	size_t m_pos = 0;
+
+}; // LineScanner
+
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "shadertrans/SpirvSpan.h"
+
+#include <string>
+
+namespace shadertrans
+{
+
+// Read-only memory mapping of a whole file.
+class MappedFile
+{
+public:
+	MappedFile(const std::string& filepath);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator = (const MappedFile&) = delete;
+
+	bool IsValid() const { return m_data != nullptr; }
+
+	const void* Data() const { return m_data; }
+	size_t Size() const { return m_size; }
+
+	// the file as spirv words, a trailing partial word is ignored
+	SpirvSpan Words() const {
+		return SpirvSpan(static_cast<const unsigned int*>(m_data), m_size / sizeof(unsigned int));
+	}
+
+private:
+	const void* m_data = nullptr;
+	size_t m_size = 0;
+
+#ifdef _WIN32
+	void* m_file = nullptr;
+	void* m_mapping = nullptr;
+#endif
+
+}; // MappedFile
+
+}
\ No newline at end of file
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "shadertrans/ReflectionContext.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+
+#include <stdint.h>
+
+namespace shadertrans
+{
+
+class MappedFile;
+
+// Reflection results in a flat, versioned layout that is read in place,
+// so loading needs neither SPIRV-Cross nor SpvGenTwo.
+//
+//   Header
+//   Variable[variable_count]    uniforms, same tree layout as UniformTable
+//   Function[function_count]
+//   Variable[argument_count]    function arguments
+//   char[string_bytes]          null terminated names
+//
+// All fields are 32-bit little endian, names are byte offsets into the
+// string section.
+class ReflectionBinary
+{
+public:
+	static const uint32_t MAGIC = 0x46525453; // "STRF"
+	static const uint32_t VERSION = 1;
+
+	static const uint32_t NO_PARENT = 0xffffffff;
+
+	struct Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t root_count;
+		uint32_t variable_count;
+		uint32_t function_count;
+		uint32_t argument_count;
+		uint32_t string_bytes;
+		uint32_t reserved;
+	};
+
+	struct Variable
+	{
+		uint32_t name;
+		uint32_t type;	// ShaderReflection::VarType
+
+		uint32_t binding;
+
+		uint32_t offset;
+		uint32_t size;
+		uint32_t array_stride;
+		uint32_t matrix_stride;
+		uint32_t array_size;
+
+		uint32_t parent;
+		uint32_t first_child, child_count;
+	};
+
+	struct Function
+	{
+		uint32_t name;
+		uint32_t ret_type;	// ShaderReflection::VarType
+		uint32_t first_argument, argument_count;
+	};
+
+	static void Write(const ReflectionContext& ctx, const ReflectionContext::UniformTable& uniforms,
+		const std::vector<std::pair<std::string, ShaderReflection::Function>>& funcs, std::vector<uint8_t>& out);
+
+	static bool Write(const ReflectionContext& ctx, const ReflectionContext::UniformTable& uniforms,
+		const std::vector<std::pair<std::string, ShaderReflection::Function>>& funcs, const std::string& filepath);
+
+	// Validates the header and the section bounds once, after that every
+	// access is a plain pointer read. The data must stay alive and be
+	// 4-byte aligned.
+	class View
+	{
+	public:
+		bool Open(const void* data, size_t size);
+		bool OpenFile(const std::string& filepath);
+
+		bool IsValid() const { return m_header != nullptr; }
+
+		uint32_t GetRootCount() const { return m_header->root_count; }
+		uint32_t GetVariableCount() const { return m_header->variable_count; }
+		const Variable* GetVariables() const { return m_variables; }
+
+		uint32_t GetFunctionCount() const { return m_header->function_count; }
+		const Function* GetFunctions() const { return m_functions; }
+		const Variable* GetArguments() const { return m_arguments; }
+
+		std::string_view GetName(uint32_t name) const {
+			return name < m_header->string_bytes ? std::string_view(m_strings + name) : std::string_view();
+		}
+
+		const Function* FindFunction(std::string_view name) const;
+
+		// rebuild the ShaderReflection trees
+		void GetUniforms(std::vector<ShaderReflection::Variable>& uniforms) const;
+		bool GetFunction(std::string_view name, ShaderReflection::Function& func) const;
+
+	private:
+		ShaderReflection::Variable ToVariable(const Variable& var) const;
+
+	private:
+		const Header*   m_header    = nullptr;
+		const Variable* m_variables = nullptr;
+		const Function* m_functions = nullptr;
+		const Variable* m_arguments = nullptr;
+		const char*     m_strings   = nullptr;
+
+		std::shared_ptr<MappedFile> m_file;
+
+	}; // View
+
+}; // ReflectionBinary
+
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "shadertrans/ShaderReflection.h"
+#include "shadertrans/StringPool.h"
+#include "shadertrans/SpirvSpan.h"
+
+namespace shadertrans
+{
+
+// Owns the names of everything reflected through it, so a name shared by
+// many variables or shaders is stored once and compared as an integer.
+class ReflectionContext
+{
+public:
+	typedef StringPool::Handle Handle;
+	static const uint32_t INVALID_INDEX = 0xffffffff;
+
+	// ShaderReflection::Variable with an interned name, children are a
+	// range of the same table
+	struct Variable
+	{
+		Handle name = StringPool::INVALID;
+		ShaderReflection::VarType type = ShaderReflection::VarType::Unknown;
+
+		uint32_t binding = 0;
+
+		uint32_t offset = 0;
+		uint32_t size = 0;
+		uint32_t array_stride = 0;
+		uint32_t matrix_stride = 0;
+		uint32_t array_size = 0;
+
+		uint32_t parent = INVALID_INDEX;
+		uint32_t first_child = 0, child_count = 0;
+	};
+
+	// The roots are variables[0, root_count), the children of a variable
+	// are stored next to each other.
+	struct UniformTable
+	{
+		std::vector<Variable> variables;
+		uint32_t root_count = 0;
+	};
+
+public:
+	void GetUniforms(SpirvSpan spirv, UniformTable& table, bool compact_arrays = false);
+
+	void Flatten(const std::vector<ShaderReflection::Variable>& uniforms, UniformTable& table);
+
+	Handle Intern(std::string_view name) { return m_names.Intern(name); }
+
+	// INVALID for a name that nothing reflected so far has
+	Handle FindName(std::string_view name) const { return m_names.Find(name); }
+	std::string_view GetName(Handle name) const { return m_names.Get(name); }
+
+	const StringPool& GetStringPool() const { return m_names; }
+
+private:
+	StringPool m_names;
+
+}; // ReflectionContext
+
+}
\ No newline at end of file
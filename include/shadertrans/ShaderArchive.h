@@ -0,0 +1,111 @@
+#pragma once
+
+#include "shadertrans/SpirvSpan.h"
+#include "shadertrans/ReflectionBinary.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_set>
+#include <memory>
+
+#include <stdint.h>
+
+namespace shadertrans
+{
+
+class MappedFile;
+
+// Many SPIR-V modules in one file that is mapped once and read in place.
+//
+//   Header
+//   Entry[entry_count]      sorted by name hash
+//   payloads                SPIR-V words and ReflectionBinary sections,
+//                           each 8-byte aligned
+//   char[names_bytes]       null terminated entry names
+class ShaderArchive
+{
+public:
+	static const uint32_t MAGIC = 0x52415453; // "STAR"
+	static const uint32_t VERSION = 1;
+
+	struct Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t entry_count;
+		uint32_t names_bytes;
+		uint64_t names_offset;
+	};
+
+	struct Entry
+	{
+		uint64_t hash;
+		uint64_t spirv_offset;
+		uint64_t spirv_words;
+		uint64_t reflection_offset;
+		uint64_t reflection_bytes;	// 0 without reflection
+		uint32_t name;
+		uint32_t reserved;
+	};
+
+	static uint64_t HashName(std::string_view name);
+
+	class Writer
+	{
+	public:
+		// false if the name is already in the archive
+		bool Add(const std::string& name, SpirvSpan spirv,
+			const std::vector<uint8_t>& reflection = std::vector<uint8_t>());
+
+		void Write(std::vector<uint8_t>& out) const;
+		bool Write(const std::string& filepath) const;
+
+	private:
+		struct Item
+		{
+			std::string name;
+			std::vector<unsigned int> spirv;
+			std::vector<uint8_t> reflection;
+		};
+		std::vector<Item> m_items;
+		std::unordered_set<std::string> m_names;
+
+	}; // Writer
+
+	// Hands out spans into the mapping, valid while the reader is alive.
+	class Reader
+	{
+	public:
+		bool Open(const std::string& filepath);
+		bool Open(const void* data, size_t size);
+
+		bool IsValid() const { return m_header != nullptr; }
+
+		size_t Size() const { return m_header ? m_header->entry_count : 0; }
+		std::string_view GetName(size_t idx) const;
+		SpirvSpan GetSpirv(size_t idx) const;
+		bool GetReflection(size_t idx, ReflectionBinary::View& view) const;
+
+		// Size() if not found
+		size_t Find(std::string_view name) const;
+
+		SpirvSpan FindSpirv(std::string_view name) const {
+			auto idx = Find(name);
+			return idx < Size() ? GetSpirv(idx) : SpirvSpan();
+		}
+
+	private:
+		const uint8_t* m_data = nullptr;
+
+		const Header* m_header  = nullptr;
+		const Entry*  m_entries = nullptr;
+		const char*   m_names   = nullptr;
+
+		std::shared_ptr<MappedFile> m_file;
+
+	}; // Reader
+
+}; // ShaderArchive
+
+}
\ No newline at end of file
@@ -1,9 +1,11 @@
 #pragma once
 
 #include "shadertrans/ShaderStage.h"
+#include "shadertrans/SpirvTools.h"
 
 #include <vector>
 #include <string>
+#include <string_view>
 #include <memory>
 #include <set>
 #include <map>
@@ -46,13 +48,14 @@ public:
 	spvgentwo::Instruction* AddUniform(spvgentwo::Module* module, const std::string& name, const std::string& type);
 	const char* QueryUniformName(const spvgentwo::Instruction* unif) const;
 
-	std::shared_ptr<Module> AddModule(ShaderStage stage, const std::string& code, const std::string& lang, const std::string& name, const std::string& entry_point);
+	std::shared_ptr<Module> AddModule(ShaderStage stage, std::string_view code, const std::string& lang, const std::string& name, const std::string& entry_point);
 
 	void ReplaceFunc(spvgentwo::Function* from, spvgentwo::Function* to);
 
 	void AddLinkDecl(spvgentwo::Function* func, const std::string& name, bool is_export);
 
-	std::vector<uint32_t> Link();
+	// empty if linking or the optimize pass fails
+	std::vector<uint32_t> Link(const SpirvTools::OptimizeOptions& optimize = SpirvTools::OptimizeOptions());
 	std::string ConnectCSMain(const std::string& glsl);
 
 private:
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+
+#include <stdint.h>
+
+namespace shadertrans
+{
+
+// In-memory spirv cache, keyed by a content hash of everything that affects
+// the compile output. Disabled by default.
+class ShaderCache
+{
+public:
+	static ShaderCache& Instance();
+
+	void SetEnable(bool enable) { m_enable = enable; }
+	bool IsEnable() const { return m_enable; }
+
+	bool Query(uint64_t key, std::vector<unsigned int>& spirv);
+	void Insert(uint64_t key, const std::vector<unsigned int>& spirv);
+
+	void Clear();
+
+	size_t GetHitCount() const { return m_hit_count; }
+	size_t GetMissCount() const { return m_miss_count; }
+	size_t GetEntryCount() const;
+
+private:
+	ShaderCache() {}
+
+private:
+	std::atomic<bool> m_enable = false;
+
+	mutable std::mutex m_mutex;
+	std::unordered_map<uint64_t, std::vector<unsigned int>> m_entries;
+
+	std::atomic<size_t> m_hit_count = 0;
+	std::atomic<size_t> m_miss_count = 0;
+
+}; // ShaderCache
+
+}
\ No newline at end of file
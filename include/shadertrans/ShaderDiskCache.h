@@ -0,0 +1,66 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+
+#include <stdint.h>
+
+namespace shadertrans
+{
+
+// Persistent cache shared across processes.
+// Layout: <root>/v<format>/<first two hex digits>/<key hex>.bin
+// Entries are written to a temp file then renamed, so readers never see a
+// partial entry. Reads bump the file's mtime, and the oldest entries are
+// evicted once the total size exceeds the budget.
+class ShaderDiskCache
+{
+public:
+	static ShaderDiskCache& Instance();
+
+	// empty root disables the cache
+	void SetRoot(const std::string& root, uint64_t max_bytes = 256ull * 1024 * 1024);
+	bool IsEnable() const { return m_enable; }
+
+	bool Load(uint64_t key, std::vector<unsigned int>& spirv);
+	bool Load(uint64_t key, std::string& text);
+
+	void Store(uint64_t key, const std::vector<unsigned int>& spirv);
+	void Store(uint64_t key, const std::string& text);
+
+	void Clear();
+
+	size_t GetHitCount() const { return m_hit_count; }
+	size_t GetMissCount() const { return m_miss_count; }
+
+	static const uint32_t FORMAT_VERSION = 1;
+
+private:
+	ShaderDiskCache() {}
+
+	std::string EntryPath(uint64_t key) const;
+
+	bool ReadEntry(uint64_t key, std::string& payload);
+	void WriteEntry(uint64_t key, const void* data, size_t size);
+	void RemoveEntry(const std::string& path);
+
+	void Evict();
+
+private:
+	std::atomic<bool> m_enable = false;
+
+	mutable std::mutex m_mutex;
+	std::string m_dir;
+	uint64_t m_max_bytes = 0;
+	uint64_t m_curr_bytes = 0;
+
+	std::atomic<size_t> m_hit_count = 0;
+	std::atomic<size_t> m_miss_count = 0;
+
+	std::atomic<uint32_t> m_tmp_id = 0;
+
+}; // ShaderDiskCache
+
+}
\ No newline at end of file
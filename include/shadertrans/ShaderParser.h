@@ -1,6 +1,9 @@
 #pragma once
 
+#include "shadertrans/ShaderStage.h"
+
 #include <string>
+#include <string_view>
 
 namespace glslang { class TShader; }
 
@@ -10,8 +13,9 @@ namespace shadertrans
 class ShaderParser
 {
 public:
+	// shader is only read during the call
 	static glslang::TShader* 
-		ParseHLSL(const std::string& shader);
+		ParseHLSL(std::string_view shader, TargetEnv target_env = TargetEnv::Vulkan_1_0);
 
 }; // ShaderParser
 
@@ -1,8 +1,10 @@
 #pragma once
 
 #include "shadertrans/ShaderStage.h"
+#include "shadertrans/IncludeResolver.h"
 
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace shadertrans
@@ -11,23 +13,31 @@ namespace shadertrans
 class ShaderPreprocess
 {
 public:
-	static std::string PrepareGLSL(ShaderStage stage, const std::string& source_code);
+	static std::string PrepareGLSL(ShaderStage stage, std::string_view source_code);
+	// edits source_code in place and moves it out
+	static std::string PrepareGLSL(ShaderStage stage, std::string&& source_code);
+	static std::string PrepareGLSL(ShaderStage stage, const char* source_code) {
+		return PrepareGLSL(stage, std::string_view(source_code));
+	}
 
 	// todo: use IR info
 	// fix glsl code trans from hlsl
-	static std::string PrepareHLSL(const std::string& source_code, const std::string& entry_point);
+	static std::string PrepareHLSL(std::string_view source_code, const std::string& entry_point);
 
-	static std::string RemoveIncludes(const std::string& source_code, 
+	static std::string RemoveIncludes(std::string_view source_code,
 		std::vector<std::string>& include_paths);
 
-	static std::string ReplaceIncludes(const std::string& source_code);
+	// see IncludeResolver for the lookup order
+	static std::string ReplaceIncludes(std::string_view source_code,
+		const std::vector<std::string>& search_paths = std::vector<std::string>());
+	// also returns every file that was expanded
+	static std::string ReplaceIncludes(std::string_view source_code, const std::vector<std::string>& search_paths,
+		std::vector<IncludeResolver::Dependency>& dependencies);
 
 	static void StringReplace(std::string& str, const std::string& from, const std::string& to);
 
 private:
-	static std::string LoadWithInclude(std::istream& cin);
-
-	static bool GetPathFromLine(const std::string& line, std::string& path);
+	static bool GetPathFromLine(std::string_view line, std::string& path);
 
 }; // ShaderPreprocess
 
@@ -1,6 +1,9 @@
 #pragma once
 
+#include "shadertrans/SpirvSpan.h"
+
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace shadertrans
@@ -35,9 +38,23 @@ public:
     struct Variable
     {
         std::string name;
-        VarType type;
+        VarType type = VarType::Unknown;
+
+        // members of a uniform block share the block's binding
+        uint32_t binding = 0;
 
-        uint32_t binding;
+        // std140/std430 layout in bytes, relative to the start of the
+        // enclosing buffer block; all zero outside of blocks
+        uint32_t offset = 0;
+        uint32_t size = 0;
+        uint32_t array_stride = 0;
+        uint32_t matrix_stride = 0;
+
+        // element count of an Array, 0 for runtime arrays; an array of
+        // arrays is an Array of the outermost dimension whose elements are
+        // Arrays of the next one, so array_size * array_stride always
+        // spans the whole array
+        uint32_t array_size = 0;
 
         std::vector<Variable> children;
     };
@@ -49,11 +66,15 @@ public:
     };
 
 public:
-    static void GetUniforms(const std::vector<unsigned int>& spirv, 
-        std::vector<Variable>& uniforms);
+    // With compact_arrays an Array keeps only its first element in children,
+    // the others are described by array_size and array_stride and can be
+    // built with ExpandArray when needed, one dimension at a time.
+    static void GetUniforms(SpirvSpan spirv, std::vector<Variable>& uniforms,
+        bool compact_arrays = false);
+
+    static void ExpandArray(const Variable& array, std::vector<Variable>& elements);
 
-    static bool GetFunction(const std::vector<unsigned int>& spirv,
-        const std::string& name, Function& func);
+    static bool GetFunction(SpirvSpan spirv, std::string_view name, Function& func);
 
 }; // ShaderReflection
 
@@ -18,4 +18,14 @@ enum class ShaderStage : uint32_t
     NumShaderStages,
 };
 
+// Vulkan version a module is compiled for, and the SPIR-V version that goes with it
+enum class TargetEnv : uint32_t
+{
+    Vulkan_1_0,             // SPIR-V 1.0
+    Vulkan_1_1,             // SPIR-V 1.3
+    Vulkan_1_1_Spirv_1_4,
+    Vulkan_1_2,             // SPIR-V 1.5
+    Vulkan_1_3,             // SPIR-V 1.6
+};
+
 }
\ No newline at end of file
@@ -1,8 +1,13 @@
 #pragma once
 
 #include "shadertrans/ShaderStage.h"
+#include "shadertrans/HLSLOptions.h"
+#include "shadertrans/SpirvTools.h"
+#include "shadertrans/IncludeResolver.h"
+#include "shadertrans/SpirvSpan.h"
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <iostream>
 
@@ -12,13 +17,106 @@ namespace shadertrans
 class ShaderTrans
 {
 public:
-	static void HLSL2SpirV(ShaderStage stage, const std::string& hlsl, const std::string& entry_point,
+	enum class Language
+	{
+		GLSL,
+		HLSL,
+	};
+
+	struct GLSLOptions
+	{
+		bool no_link = false;
+		TargetEnv target_env = TargetEnv::Vulkan_1_0;
+		SpirvTools::OptimizeOptions optimize;
+	};
+
+	// see HLSLOptions.h
+	typedef shadertrans::HLSLOptions HLSLOptions;
+
+	struct BatchJob
+	{
+		ShaderStage stage;
+		Language lang;
+		// owned, jobs outlive the caller's buffers; move sources in
+		std::string source;
+		std::string entry_point;
+		std::string inc_dir;
+		bool no_link = false;
+		TargetEnv target_env = TargetEnv::Vulkan_1_0;
+		SpirvTools::OptimizeOptions optimize;
+	};
+
+	struct BatchResult
+	{
+		std::vector<unsigned int> spirv;
+		std::string log;
+
+		// for depfiles: GLSL lists the headers glslang opened, HLSL the
+		// headers reachable from the source through inc_dir
+		std::vector<IncludeResolver::Dependency> dependencies;
+	};
+
+	// name and value, an empty value defines the name without one
+	typedef std::vector<std::pair<std::string, std::string>> DefineSet;
+
+	struct PermutationResult
+	{
+		// variant i compiled to outputs[variants[i]], variants with the same
+		// preprocessed text share an output
+		std::vector<size_t> variants;
+		std::vector<BatchResult> outputs;
+
+		// headers opened by any variant
+		std::vector<IncludeResolver::Dependency> dependencies;
+	};
+
+public:
+	// false if dxcompiler can't be loaded
+	static bool IsHLSLAvailable();
+
+	// sources are only read, views into mapped files or larger buffers work
+	// spirv is left empty on any failure, including a failed optimize pass
+	static void HLSL2SpirV(ShaderStage stage, std::string_view hlsl, const std::string& entry_point,
 		std::vector<unsigned int>& spirv, std::ostream& out = std::cerr);
-	static void GLSL2SpirV(ShaderStage stage, const std::string& glsl, const char* inc_dir,
+	static void HLSL2SpirV(ShaderStage stage, std::string_view hlsl, const std::string& entry_point,
+		const HLSLOptions& options, std::vector<unsigned int>& spirv, std::ostream& out = std::cerr);
+	static void GLSL2SpirV(ShaderStage stage, std::string_view glsl, const char* inc_dir,
 		std::vector<unsigned int>& spirv, bool no_link = false, std::ostream& out = std::cerr);
-	static void SpirV2GLSL(ShaderStage stage, const std::vector<unsigned int>& spirv,
+	static void GLSL2SpirV(ShaderStage stage, std::string_view glsl, const char* inc_dir,
+		const GLSLOptions& options, std::vector<unsigned int>& spirv, std::ostream& out = std::cerr);
+	// also returns the headers the compile opened, see IncludeResolver for
+	// the lookup order; on a cache hit they are resolved from the text
+	// instead, which may list includes under a false #if
+	static void GLSL2SpirV(ShaderStage stage, std::string_view glsl, const char* inc_dir,
+		const GLSLOptions& options, std::vector<unsigned int>& spirv,
+		std::vector<IncludeResolver::Dependency>& dependencies, std::ostream& out = std::cerr);
+	static void SpirV2GLSL(ShaderStage stage, SpirvSpan spirv,
 		std::string& glsl, bool use_ubo = false, std::ostream& out = std::cerr);
 
+	// return by value, empty on failure
+	static std::vector<unsigned int> HLSL2SpirV(ShaderStage stage, std::string_view hlsl,
+		const std::string& entry_point, const HLSLOptions& options, std::ostream& out = std::cerr);
+	static std::vector<unsigned int> GLSL2SpirV(ShaderStage stage, std::string_view glsl,
+		const char* inc_dir, const GLSLOptions& options, std::ostream& out = std::cerr);
+	static std::string SpirV2GLSL(ShaderStage stage, SpirvSpan spirv,
+		bool use_ubo = false, std::ostream& out = std::cerr);
+
+	// Compiles the jobs on thread_num workers (0 for one per core),
+	// results[i] belongs to jobs[i].
+	static void BatchToSpirV(const std::vector<BatchJob>& jobs,
+		std::vector<BatchResult>& results, int thread_num = 0);
+
+	// Preprocesses glsl once per define set, then compiles only the distinct
+	// texts on thread_num workers.
+	static void PermutationToSpirV(ShaderStage stage, std::string_view glsl, const char* inc_dir,
+		const GLSLOptions& options, const std::vector<DefineSet>& variants,
+		PermutationResult& result, int thread_num = 0);
+
+private:
+	static void CompileGLSL(ShaderStage stage, std::string_view glsl, const char* inc_dir,
+		const GLSLOptions& options, std::vector<unsigned int>& spirv,
+		std::vector<IncludeResolver::Dependency>* dependencies, std::ostream& out);
+
 }; // ShaderTrans
 
 }
\ No newline at end of file
@@ -1,22 +1,34 @@
 #pragma once
 
 #include "shadertrans/ShaderStage.h"
+#include "shadertrans/HLSLOptions.h"
 
 #include <glslang/Public/ShaderLang.h>
 
 #include <string>
+#include <string_view>
 #include <map>
 #include <memory>
+#include <vector>
+#include <mutex>
+#include <iostream>
 
 namespace shadertrans
 {
 
+// Validate() is thread-safe. GLSL compilers are pooled, so concurrent
+// calls on the same validator don't share a glslang handle.
 class ShaderValidator
 {
 public:
 	ShaderValidator(ShaderStage stage);
 
-	bool Validate(const std::string& code, bool is_glsl, std::ostream& out) const;
+	// code is only read, views into larger buffers work
+	bool Validate(std::string_view code, bool is_glsl, std::ostream& out) const;
+
+	// HLSL is validated with these, pass the options it ships with so both
+	// see the same code. Defaults to -O3. Not safe during Validate().
+	void SetHLSLOptions(const shadertrans::HLSLOptions& options) { m_hlsl_options = options; }
 
 private:
 	class CompilerGLSL
@@ -25,7 +37,7 @@ private:
 		CompilerGLSL(ShaderStage lang);
 		~CompilerGLSL();
 
-		bool Validate(const std::string& code, std::ostream& out) const;
+		bool Validate(std::string_view code, std::ostream& out) const;
 
 	private:
 		ShHandle m_compiler = nullptr;
@@ -35,7 +47,10 @@ private:
 private:
 	ShaderStage m_stage;
 
-	mutable std::unique_ptr<CompilerGLSL> m_glsl;
+	shadertrans::HLSLOptions m_hlsl_options;
+
+	mutable std::mutex m_glsl_mutex;
+	mutable std::vector<std::unique_ptr<CompilerGLSL>> m_glsl_pool;
 
 }; // ShaderValidator
 
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>
+#if __cplusplus >= 202002L
+#include <span>
+#endif
+
+#include <stddef.h>
+
+namespace shadertrans
+{
+
+// Non-owning view of spirv words, the caller keeps the buffer alive.
+class SpirvSpan
+{
+public:
+	SpirvSpan() {}
+	SpirvSpan(const unsigned int* data, size_t size)
+		: m_data(data), m_size(size) {}
+	SpirvSpan(const std::vector<unsigned int>& spirv)
+		: m_data(spirv.data()), m_size(spirv.size()) {}
+#if __cplusplus >= 202002L
+	SpirvSpan(std::span<const unsigned int> spirv)
+		: m_data(spirv.data()), m_size(spirv.size()) {}
+#endif
+
+	const unsigned int* data() const { return m_data; }
+	size_t size() const { return m_size; }
+	bool empty() const { return m_size == 0; }
+
+	const unsigned int* begin() const { return m_data; }
+	const unsigned int* end() const { return m_data + m_size; }
+
+	const unsigned int& operator [] (size_t i) const { return m_data[i]; }
+
+	std::vector<unsigned int> ToVector() const {
+		return std::vector<unsigned int>(begin(), end());
+	}
+
+private:
+	const unsigned int* m_data = nullptr;
+	size_t m_size = 0;
+
+}; // SpirvSpan
+
+}
\ No newline at end of file
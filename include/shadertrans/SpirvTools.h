@@ -1,17 +1,53 @@
 #pragma once
 
+#include "shadertrans/ShaderStage.h"
+
 #include <vector>
 #include <string>
+#include <iostream>
+
+namespace spvtools { class Context; class SpirvTools; }
 
 namespace shadertrans
 {
 
 class SpirvTools
 {
+public:
+    enum class Optimization
+    {
+        None,
+        Size,
+        Performance,
+        // OptimizeOptions::passes, spirv-opt flags such as "--eliminate-dead-code-aggressive"
+        Custom,
+    };
+
+    struct OptimizeOptions
+    {
+        Optimization preset = Optimization::None;
+        std::vector<std::string> passes;
+    };
+
 public:
     static bool Assemble(const char* text, size_t text_size, std::vector<uint32_t>* binary);
     static bool Disassemble(const uint32_t* binary, size_t binary_size, std::string* text);
 
+    // In place, spirv is left untouched on failure. Without an env the
+    // module is taken as universal SPIR-V 1.5.
+    static bool Optimize(std::vector<uint32_t>& spirv, const OptimizeOptions& options,
+        std::ostream& out = std::cerr);
+    static bool Optimize(std::vector<uint32_t>& spirv, const OptimizeOptions& options,
+        TargetEnv env, std::ostream& out = std::cerr);
+
+    // Created on first use in each thread and kept, so the grammar tables
+    // are only set up once per thread instead of once per call.
+    static const spvtools::SpirvTools& Tools();
+    // for spvtools::Link, reports to stdout/stderr, universal SPIR-V 1.5
+    // or the given env
+    static const spvtools::Context& LinkContext();
+    static const spvtools::Context& LinkContext(TargetEnv env);
+
 }; // SpirvTools
 
 }
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+
+#include <stdint.h>
+
+namespace shadertrans
+{
+
+// Interned strings, each distinct string is stored once and referred to by
+// a handle. Equal strings always get the same handle. Not thread safe.
+class StringPool
+{
+public:
+	typedef uint32_t Handle;
+	static const Handle INVALID = 0xffffffff;
+
+	Handle Intern(std::string_view str);
+
+	// INVALID if str has never been interned
+	Handle Find(std::string_view str) const;
+
+	// null terminated, valid until Clear()
+	std::string_view Get(Handle handle) const {
+		return handle < m_strings.size() ? m_strings[handle] : std::string_view();
+	}
+
+	size_t Size() const { return m_strings.size(); }
+	size_t GetBytes() const { return m_bytes; }
+
+	void Clear();
+
+private:
+	const char* Store(std::string_view str);
+
+private:
+	static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+	// chunks never move, so the views stay valid as the pool grows
+	std::vector<std::unique_ptr<char[]>> m_chunks;
+	size_t m_chunk_used = 0, m_chunk_cap = 0;
+
+	std::vector<std::string_view> m_strings;
+	std::unordered_map<std::string_view, Handle> m_lookup;
+
+	size_t m_bytes = 0;
+
+}; // StringPool
+
+}
\ No newline at end of file
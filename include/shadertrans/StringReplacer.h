@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+
+#include <stdint.h>
+
+namespace shadertrans
+{
+
+// Applies a whole substitution table in one pass, through an Aho-Corasick
+// automaton. Matches are leftmost, the longest pattern wins at the same
+// start, and replaced text isn't scanned again.
+// Each replacement rescans the bytes read past it while a longer match was
+// still possible, fewer than the longest pattern, so the cost is
+// O(n + replacements * longest pattern): linear for short tables like the
+// ones ShaderPreprocess uses, O(n * L) at worst when short and long
+// patterns overlap on every byte.
+class StringReplacer
+{
+public:
+	// from and to, empty froms are ignored, the first of duplicates wins
+	StringReplacer(const std::vector<std::pair<std::string, std::string>>& table);
+
+	std::string Apply(std::string_view str) const;
+	// appends to out
+	void Apply(std::string_view str, std::string& out) const;
+
+	bool IsEmpty() const { return m_patterns.empty(); }
+
+private:
+	void Build();
+
+private:
+	std::vector<std::pair<std::string, std::string>> m_patterns;
+
+	// dfa over bytes, the root is state 0
+	std::vector<std::array<int32_t, 256>> m_next;
+	std::vector<int32_t> m_depth;
+	// longest pattern that ends at the state, -1 for none
+	std::vector<int32_t> m_output;
+
+}; // StringReplacer
+
+}
\ No newline at end of file
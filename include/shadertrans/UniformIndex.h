@@ -0,0 +1,73 @@
+#pragma once
+
+#include "shadertrans/ReflectionContext.h"
+
+#include <string_view>
+#include <vector>
+
+#include <stdint.h>
+
+namespace shadertrans
+{
+
+// Maps full uniform paths, e.g. "ubo.lights[3].color", to their entry in a
+// ReflectionContext::UniformTable. Build once per reflected shader, then
+// look up by path or by a hash precomputed with HashName().
+// The index keeps a pointer to the ctx it was built from, which must
+// outlive it.
+class UniformIndex
+{
+public:
+	struct Entry
+	{
+		ReflectionContext::Handle name;
+		uint32_t binding;
+		uint32_t member;	// among the children of its parent, or the roots
+		uint32_t row;		// in UniformTable::variables
+		ShaderReflection::VarType type;
+	};
+
+public:
+	// perfect: pick a displacement per bucket so that every lookup is
+	// exactly one probe, slower to build, for frozen shader sets
+	// return false, leaving the index empty, if two different paths
+	// share a hash
+	bool Build(const ReflectionContext& ctx, const ReflectionContext::UniformTable& table,
+		bool perfect = false);
+
+	// compares the name, so a path that is not in the index never matches
+	const Entry* Find(std::string_view path) const;
+	// hash only, a path outside the index that collides with one inside
+	// it is reported as that one
+	const Entry* Find(uint64_t hash) const;
+
+	static uint64_t HashName(std::string_view path);
+
+	size_t Size() const { return m_entries.size(); }
+	bool IsPerfect() const { return !m_disp.empty(); }
+
+private:
+	bool BuildPerfect(size_t slot_count);
+
+	static uint64_t Mix(uint64_t hash, uint32_t disp);
+
+private:
+	static const uint32_t EMPTY = 0xffffffff;
+
+	struct Slot
+	{
+		uint64_t hash = 0;
+		uint32_t entry = EMPTY;
+	};
+
+	const ReflectionContext* m_ctx = nullptr;
+
+	std::vector<Entry> m_entries;
+	std::vector<uint64_t> m_hashes;
+
+	std::vector<Slot> m_slots;	// power of two
+	std::vector<uint32_t> m_disp;	// perfect hashing only, power of two
+
+}; // UniformIndex
+
+}
\ No newline at end of file
@@ -1,8 +1,11 @@
 #pragma once
 
+#include "shadertrans/SpirvSpan.h"
+
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <memory>
 
 namespace shadertrans
 {
@@ -57,7 +60,13 @@ struct Module
 	int derivative_inst_count;
 	int control_flow_inst_count;
 
+	// Owned words in spv, or borrowed ones in spv_view (spv empty), which
+	// spv_holder keeps alive when set, e.g. a mapped file.
 	std::vector<unsigned int> spv;
+	SpirvSpan spv_view;
+	std::shared_ptr<const void> spv_holder;
+
+	SpirvSpan GetSpirv() const { return spv.empty() ? spv_view : SpirvSpan(spv); }
 };
 
 }
@@ -1,10 +1,12 @@
 #pragma once
 
 #include "shadertrans/ShaderStage.h"
+#include "shadertrans/SpirvSpan.h"
 
 #include <vector>
 #include <memory>
 #include <string>
+#include <string_view>
 
 namespace shadertrans
 {
@@ -16,11 +18,19 @@ struct Module;
 class Linker
 {
 public:
-	void AddModule(ShaderStage stage, const std::string& glsl);
+	// modules are compiled for and linked at target_env
+	Linker(TargetEnv target_env = TargetEnv::Vulkan_1_0)
+		: m_target_env(target_env) {}
+
+	void AddModule(ShaderStage stage, std::string_view glsl);
+	// borrows the words, they must outlive the linker
+	void AddModule(SpirvSpan spv);
 
 	void Link();
 
 private:
+	TargetEnv m_target_env;
+
 	std::vector<std::shared_ptr<Module>> m_modules;
 
 }; // Linker
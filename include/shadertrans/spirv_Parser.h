@@ -10,7 +10,16 @@ namespace spirv
 class Parser 
 {
 public:
+	// copies the words into module.spv
 	static void Parse(const std::vector<unsigned int>& spv, Module& module);
+	static void Parse(std::vector<unsigned int>&& spv, Module& module);
+	// borrows the words, they must outlive the module
+	static void Parse(SpirvSpan spv, Module& module);
+	// maps the file, the mapping is owned by the module
+	static bool ParseFile(const std::string& filepath, Module& module);
+
+private:
+	static void ParseWords(SpirvSpan spv, Module& module);
 
 }; // Parser
 
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "shadertrans/ShaderReflection.h"
+#include "shadertrans/ReflectionContext.h"
+#include "shadertrans/SpirvSpan.h"
+
+namespace shadertrans
+{
+namespace spirv
+{
+
+// Reflection straight from the words in a single scan, without building a
+// SPIRV-Cross compiler or a SpvGenTwo module. Produces the same trees as
+// ShaderReflection::GetUniforms and ShaderReflection::GetFunction.
+class Reflection
+{
+public:
+	static void GetUniforms(SpirvSpan spirv,
+		std::vector<ShaderReflection::Variable>& uniforms, bool compact_arrays = false);
+	// the same uniforms laid out as ReflectionContext::Flatten() would, names
+	// are interned into ctx during the scan without building string trees
+	static void GetUniforms(SpirvSpan spirv, ReflectionContext& ctx,
+		ReflectionContext::UniformTable& table, bool compact_arrays = false);
+
+	static bool GetFunction(SpirvSpan spirv,
+		const std::string& name, ShaderReflection::Function& func);
+
+	// every function in the module, with names as GetFunction matches them
+	static bool GetFunctions(SpirvSpan spirv,
+		std::vector<std::pair<std::string, ShaderReflection::Function>>& funcs);
+
+}; // Reflection
+
+}
+}
\ No newline at end of file
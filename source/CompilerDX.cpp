@@ -1,6 +1,9 @@
 #include "shadertrans/CompilerDX.h"
 
 #include <cstdlib> // getenv (macOS/Linux dxcompiler fallback search)
+#include <thread>
+#include <algorithm>
+#include <fstream>
 
 namespace
 {
@@ -79,88 +82,224 @@ namespace shadertrans
 
 CompilerDX::CompilerDX()
 {
-    if (m_dllDetaching)
+    m_pool_max = std::max(1u, std::thread::hardware_concurrency());
+}
+
+CompilerDX::~CompilerDX()
+{
+    this->Destroy();
+}
+
+CompilerDX& CompilerDX::Instance()
+{
+    static CompilerDX instance;
+    return instance;
+}
+
+bool CompilerDX::IsAvailable()
+{
+    Load();
+    return m_createInstanceFunc != nullptr;
+}
+
+IDxcLibrary* CompilerDX::Library()
+{
+    InitDefaultInstances();
+    return m_library;
+}
+
+IDxcCompiler* CompilerDX::Compiler()
+{
+    InitDefaultInstances();
+    return m_compiler;
+}
+
+CComPtr<IDxcLinker> CompilerDX::CreateLinker()
+{
+    CheckAvailable();
+
+    CComPtr<IDxcLinker> linker;
+    IFT(m_createInstanceFunc(CLSID_DxcLinker, __uuidof(IDxcLinker), reinterpret_cast<void**>(&linker)));
+    return linker;
+}
+
+bool CompilerDX::LinkerSupport()
+{
+    std::call_once(m_linker_flag, [this]() {
+        m_linkerSupport = IsAvailable() && CreateLinker() != nullptr;
+    });
+    return m_linkerSupport;
+}
+
+void CompilerDX::Load()
+{
+    std::call_once(m_load_flag, [this]()
     {
-        return;
-    }
+        if (m_dllDetaching)
+        {
+            return;
+        }
 
 #ifdef _WIN32
-    const char* dllName = "dxcompiler.dll";
+        const char* dllName = "dxcompiler.dll";
 #elif __APPLE__
-    const char* dllName = "libdxcompiler.dylib";
+        const char* dllName = "libdxcompiler.dylib";
 #else
-    const char* dllName = "libdxcompiler.so";
+        const char* dllName = "libdxcompiler.so";
 #endif
-    const char* functionName = "DxcCreateInstance";
+        const char* functionName = "DxcCreateInstance";
 
 #ifdef _WIN32
-    m_dxcompilerDll = ::LoadLibraryA(dllName);
+        m_dxcompilerDll = ::LoadLibraryA(dllName);
 #else
-    m_dxcompilerDll = ::dlopen(dllName, RTLD_LAZY);
-    // A bare dlopen only searches DYLD_LIBRARY_PATH / the dyld fallback path. That
-    // is set when launching from the command line but NOT when launching from an
-    // IDE (e.g. Xcode), so fall back to known absolute install locations.
-    if (m_dxcompilerDll == nullptr)
-    {
-        if (const char* vk = ::getenv("VULKAN_SDK")) {
-            std::string p = std::string(vk) + "/lib/" + dllName;
+        m_dxcompilerDll = ::dlopen(dllName, RTLD_LAZY);
+        // A bare dlopen only searches DYLD_LIBRARY_PATH / the dyld fallback path. That
+        // is set when launching from the command line but NOT when launching from an
+        // IDE (e.g. Xcode), so fall back to known absolute install locations.
+        if (m_dxcompilerDll == nullptr)
+        {
+            if (const char* vk = ::getenv("VULKAN_SDK")) {
+                std::string p = std::string(vk) + "/lib/" + dllName;
+                m_dxcompilerDll = ::dlopen(p.c_str(), RTLD_LAZY);
+            }
+        }
+        if (m_dxcompilerDll == nullptr) {
+            std::string p = std::string("/usr/local/lib/") + dllName;
             m_dxcompilerDll = ::dlopen(p.c_str(), RTLD_LAZY);
         }
-    }
-    if (m_dxcompilerDll == nullptr) {
-        std::string p = std::string("/usr/local/lib/") + dllName;
-        m_dxcompilerDll = ::dlopen(p.c_str(), RTLD_LAZY);
-    }
 #endif
 
-    if (m_dxcompilerDll != nullptr)
-    {
+        if (m_dxcompilerDll != nullptr)
+        {
 #ifdef _WIN32
-        m_createInstanceFunc = (DxcCreateInstanceProc)::GetProcAddress(m_dxcompilerDll, functionName);
+            m_createInstanceFunc = (DxcCreateInstanceProc)::GetProcAddress(m_dxcompilerDll, functionName);
 #else
-        m_createInstanceFunc = (DxcCreateInstanceProc)::dlsym(m_dxcompilerDll, functionName);
+            m_createInstanceFunc = (DxcCreateInstanceProc)::dlsym(m_dxcompilerDll, functionName);
 #endif
 
-        if (m_createInstanceFunc != nullptr)
-        {
-            IFT(m_createInstanceFunc(CLSID_DxcLibrary, __uuidof(IDxcLibrary), reinterpret_cast<void**>(&m_library)));
-            IFT(m_createInstanceFunc(CLSID_DxcCompiler, __uuidof(IDxcCompiler), reinterpret_cast<void**>(&m_compiler)));
+            if (m_createInstanceFunc != nullptr)
+            {
+                return;
+            }
+
+            this->Destroy();
+
+            m_load_error = std::string("COULDN'T get ") + functionName + " from dxcompiler.";
         }
         else
         {
-            this->Destroy();
-
-            throw std::runtime_error(std::string("COULDN'T get ") + functionName + " from dxcompiler.");
+            m_load_error = "COULDN'T load dxcompiler.";
         }
+    });
+}
+
+void CompilerDX::CheckAvailable()
+{
+    if (!IsAvailable()) {
+        throw std::runtime_error(m_load_error);
     }
-    else
+}
+
+void CompilerDX::InitDefaultInstances()
+{
+    CheckAvailable();
+
+    std::call_once(m_default_flag, [this]() {
+        IFT(m_createInstanceFunc(CLSID_DxcLibrary, __uuidof(IDxcLibrary), reinterpret_cast<void**>(&m_library)));
+        IFT(m_createInstanceFunc(CLSID_DxcCompiler, __uuidof(IDxcCompiler), reinterpret_cast<void**>(&m_compiler)));
+    });
+}
+
+CompilerDX::Lease CompilerDX::Acquire()
+{
+    CheckAvailable();
+
+    std::unique_lock<std::mutex> lock(m_pool_mutex);
+    while (m_pool_free.empty())
     {
-        throw std::runtime_error("COULDN'T load dxcompiler.");
+        if (m_pool.size() < m_pool_max)
+        {
+            m_pool.push_back(CreatePoolEntry());
+            return Lease(this, m_pool.back().get());
+        }
+        m_pool_cond.wait(lock);
     }
 
-    m_linkerSupport = (CreateLinker() != nullptr);
+    auto entry = m_pool_free.back();
+    m_pool_free.pop_back();
+    return Lease(this, entry);
 }
 
-CompilerDX::~CompilerDX()
+void CompilerDX::SetPoolSize(size_t max_size, bool lazy_growth)
 {
-    this->Destroy();
+    // growing up front is the only thing here that needs the dll
+    const bool prealloc = !lazy_growth && IsAvailable();
+
+    std::lock_guard<std::mutex> lock(m_pool_mutex);
+
+    m_pool_max = std::max(max_size, size_t(1));
+
+    // drop idle pairs above the limit, busy ones are kept until released
+    while (m_pool.size() > m_pool_max && !m_pool_free.empty())
+    {
+        auto entry = m_pool_free.back();
+        m_pool_free.pop_back();
+        m_pool.erase(std::find_if(m_pool.begin(), m_pool.end(), [entry](const std::unique_ptr<PoolEntry>& e) {
+            return e.get() == entry;
+        }));
+    }
+
+    if (prealloc)
+    {
+        while (m_pool.size() < m_pool_max)
+        {
+            m_pool.push_back(CreatePoolEntry());
+            m_pool_free.push_back(m_pool.back().get());
+        }
+    }
+
+    m_pool_cond.notify_all();
 }
 
-CompilerDX& CompilerDX::Instance()
+std::unique_ptr<CompilerDX::PoolEntry> CompilerDX::CreatePoolEntry() const
 {
-    static CompilerDX instance;
-    return instance;
+    if (!m_createInstanceFunc) {
+        throw std::runtime_error("dxcompiler isn't loaded.");
+    }
+
+    auto entry = std::make_unique<PoolEntry>();
+    IFT(m_createInstanceFunc(CLSID_DxcLibrary, __uuidof(IDxcLibrary), reinterpret_cast<void**>(&entry->library)));
+    IFT(m_createInstanceFunc(CLSID_DxcCompiler, __uuidof(IDxcCompiler), reinterpret_cast<void**>(&entry->compiler)));
+    return entry;
 }
 
-CComPtr<IDxcLinker> CompilerDX::CreateLinker() const
+void CompilerDX::Release(PoolEntry* entry)
 {
-    CComPtr<IDxcLinker> linker;
-    IFT(m_createInstanceFunc(CLSID_DxcLinker, __uuidof(IDxcLinker), reinterpret_cast<void**>(&linker)));
-    return linker;
+    {
+        std::lock_guard<std::mutex> lock(m_pool_mutex);
+        if (m_pool.size() > m_pool_max)
+        {
+            // shrunk while leased
+            m_pool.erase(std::find_if(m_pool.begin(), m_pool.end(), [entry](const std::unique_ptr<PoolEntry>& e) {
+                return e.get() == entry;
+            }));
+        }
+        else
+        {
+            m_pool_free.push_back(entry);
+        }
+    }
+    m_pool_cond.notify_one();
 }
 
 void CompilerDX::Destroy()
 {
+    {
+        std::lock_guard<std::mutex> lock(m_pool_mutex);
+        m_pool_free.clear();
+        m_pool.clear();
+    }
+
     if (m_dxcompilerDll)
     {
         m_compiler = nullptr;
@@ -180,6 +319,15 @@ void CompilerDX::Destroy()
 
 void CompilerDX::Terminate()
 {
+    {
+        std::lock_guard<std::mutex> lock(m_pool_mutex);
+        for (auto& entry : m_pool)
+        {
+            entry->compiler.Detach();
+            entry->library.Detach();
+        }
+    }
+
     if (m_dxcompilerDll)
     {
         m_compiler.Detach();
@@ -191,6 +339,135 @@ void CompilerDX::Terminate()
     }
 }
 
+//////////////////////////////////////////////////////////////////////////
+// class DxcArguments
+//////////////////////////////////////////////////////////////////////////
+
+DxcArguments::DxcArguments(const HLSLOptions& options)
+{
+    m_args.push_back(L"-Zpr");
+    m_args.push_back(Store(L"-O" + std::to_wstring(std::clamp(options.opt_level, 0, 3))));
+    m_args.push_back(L"-spirv");
+
+    switch (options.target_env)
+    {
+    case TargetEnv::Vulkan_1_0:
+        m_args.push_back(L"-fspv-target-env=vulkan1.0");
+        break;
+    case TargetEnv::Vulkan_1_1:
+        m_args.push_back(L"-fspv-target-env=vulkan1.1");
+        break;
+    case TargetEnv::Vulkan_1_1_Spirv_1_4:
+        m_args.push_back(L"-fspv-target-env=vulkan1.1spirv1.4");
+        break;
+    case TargetEnv::Vulkan_1_2:
+        m_args.push_back(L"-fspv-target-env=vulkan1.2");
+        break;
+    case TargetEnv::Vulkan_1_3:
+        m_args.push_back(L"-fspv-target-env=vulkan1.3");
+        break;
+    }
+
+    if (options.spv_reflect) {
+        m_args.push_back(L"-fspv-reflect");
+    }
+
+    for (auto& dir : options.include_dirs)
+    {
+        m_args.push_back(L"-I");
+        m_args.push_back(Store(dir));
+    }
+
+    for (auto& arg : options.extra_args) {
+        m_args.push_back(Store(arg));
+    }
+
+    for (auto& define : options.defines)
+    {
+        DxcDefine d;
+        d.Name  = Store(define.first);
+        d.Value = define.second.empty() ? nullptr : Store(define.second);
+        m_defines.push_back(d);
+    }
+}
+
+const wchar_t* DxcArguments::Store(const std::string& utf8)
+{
+    std::wstring str;
+    Unicode::UTF8ToWideString(utf8.c_str(), &str);
+    return Store(std::move(str));
+}
+
+const wchar_t* DxcArguments::Store(std::wstring str)
+{
+    m_strings.push_back(std::move(str));
+    return m_strings.back().c_str();
+}
+
+//////////////////////////////////////////////////////////////////////////
+// class ScIncludeHandler
+//////////////////////////////////////////////////////////////////////////
+
+Blob* CreateBlob(const void* data, uint32_t size)
+{
+    return new Blob(data, size);
+}
+
+void DestroyBlob(Blob* blob)
+{
+    delete blob;
+}
+
+HRESULT STDMETHODCALLTYPE ScIncludeHandler::LoadSource(LPCWSTR fileName, IDxcBlob** includeSource)
+{
+    if ((fileName[0] == L'.') && (fileName[1] == L'/'))
+    {
+        fileName += 2;
+    }
+
+    std::string utf8FileName;
+    if (!Unicode::WideToUTF8String(fileName, &utf8FileName))
+    {
+        return E_FAIL;
+    }
+
+    auto blobDeleter = [](Blob* blob) { DestroyBlob(blob); };
+
+    std::unique_ptr<Blob, decltype(blobDeleter)> source(nullptr, blobDeleter);
+    try
+    {
+        source.reset(m_loadCallback(utf8FileName.c_str()));
+    }
+    catch (...)
+    {
+        return E_FAIL;
+    }
+
+    *includeSource = nullptr;
+    return m_library->CreateBlobWithEncodingOnHeapCopy(
+        source->Data(), source->Size(), CP_UTF8, reinterpret_cast<IDxcBlobEncoding**>(includeSource)
+    );
+}
+
+Blob* DefaultLoadCallback(const char* includeName)
+{
+    std::vector<char> ret;
+    std::ifstream includeFile(includeName, std::ios_base::in);
+    if (includeFile)
+    {
+        includeFile.seekg(0, std::ios::end);
+        ret.resize(static_cast<size_t>(includeFile.tellg()));
+        includeFile.seekg(0, std::ios::beg);
+        includeFile.read(ret.data(), ret.size());
+        ret.resize(static_cast<size_t>(includeFile.gcount()));
+    }
+    else
+    {
+        throw std::runtime_error(std::string("COULDN'T load included file ") + includeName + ".");
+    }
+    return CreateBlob(ret.data(), static_cast<uint32_t>(ret.size()));
+}
+
 std::wstring hlsl_shader_profile_name(shadertrans::ShaderStage stage, uint8_t major_ver, uint8_t minor_ver)
 {
     return ShaderProfileName(stage, { major_ver, minor_ver });
@@ -5,14 +5,10 @@
 namespace shadertrans
 {
 
-GLSLangAdapter* GLSLangAdapter::m_instance = nullptr;
-
 GLSLangAdapter* GLSLangAdapter::Instance()
 {
-	if (!m_instance) {
-		m_instance = new GLSLangAdapter();
-	}
-	return m_instance;
+	static GLSLangAdapter instance;
+	return &instance;
 }
 
 GLSLangAdapter::GLSLangAdapter()
@@ -21,13 +17,14 @@ GLSLangAdapter::GLSLangAdapter()
 
 GLSLangAdapter::~GLSLangAdapter()
 {
-	if (m_inited) {
-		glslang::FinalizeProcess();
-	}
+	Finalize();
 }
 
 void GLSLangAdapter::Init()
 {
+	// no unlocked fast path, it could report glslang as up while a
+	// Finalize() is inside FinalizeProcess()
+	std::lock_guard<std::mutex> lock(m_mutex);
 	if (!m_inited)
 	{
 		glslang::InitializeProcess();
@@ -35,6 +32,16 @@ void GLSLangAdapter::Init()
 	}
 }
 
+void GLSLangAdapter::Finalize()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_inited)
+	{
+		glslang::FinalizeProcess();
+		m_inited = false;
+	}
+}
+
 EShLanguage GLSLangAdapter::Type2GLSLang(shadertrans::ShaderStage stage)
 {
     switch (stage)
@@ -57,4 +64,32 @@ EShLanguage GLSLangAdapter::Type2GLSLang(shadertrans::ShaderStage stage)
     }
 }
 
+void GLSLangAdapter::TargetEnv2GLSLang(TargetEnv env, glslang::EShTargetClientVersion& client,
+                                       glslang::EShTargetLanguageVersion& target)
+{
+    switch (env)
+    {
+    case TargetEnv::Vulkan_1_1:
+        client = glslang::EShTargetVulkan_1_1;
+        target = glslang::EShTargetSpv_1_3;
+        break;
+    case TargetEnv::Vulkan_1_1_Spirv_1_4:
+        client = glslang::EShTargetVulkan_1_1;
+        target = glslang::EShTargetSpv_1_4;
+        break;
+    case TargetEnv::Vulkan_1_2:
+        client = glslang::EShTargetVulkan_1_2;
+        target = glslang::EShTargetSpv_1_5;
+        break;
+    case TargetEnv::Vulkan_1_3:
+        client = glslang::EShTargetVulkan_1_3;
+        target = glslang::EShTargetSpv_1_6;
+        break;
+    default:
+        client = glslang::EShTargetVulkan_1_0;
+        target = glslang::EShTargetSpv_1_0;
+        break;
+    }
+}
+
 }
\ No newline at end of file
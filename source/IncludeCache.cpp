@@ -0,0 +1,176 @@
+#include "shadertrans/IncludeCache.h"
+#include "shadertrans/Hasher.h"
+#include "shadertrans/LineScanner.h"
+
+#include <fstream>
+#include <sstream>
+#include <string_view>
+
+namespace
+{
+
+// "#  keyword rest" -> rest, false if line isn't that directive
+bool get_directive(std::string_view line, std::string_view keyword, std::string_view& rest)
+{
+	if (line.empty() || line[0] != '#') {
+		return false;
+	}
+	line = shadertrans::LineScanner::Trim(line.substr(1));
+	if (!shadertrans::LineScanner::StartsWith(line, keyword)) {
+		return false;
+	}
+	rest = line.substr(keyword.size());
+	if (!rest.empty() && rest[0] != ' ' && rest[0] != '\t' && rest[0] != '"' && rest[0] != '<' && rest[0] != '/' &&
+		rest[0] != '(' && rest[0] != '!') {
+		return false;
+	}
+	rest = shadertrans::LineScanner::Trim(rest);
+	return true;
+}
+
+std::string_view first_token(std::string_view str)
+{
+	auto end = str.find_first_of(" \t/");
+	return str.substr(0, end);
+}
+
+}
+
+namespace shadertrans
+{
+
+IncludeCache& IncludeCache::Instance()
+{
+	static IncludeCache instance;
+	return instance;
+}
+
+std::shared_ptr<const IncludeCache::File> IncludeCache::Load(const std::string& filepath)
+{
+	std::error_code ec;
+	auto mtime = std::filesystem::last_write_time(filepath, ec);
+	if (ec) {
+		return nullptr;
+	}
+	auto size = std::filesystem::file_size(filepath, ec);
+	if (ec) {
+		return nullptr;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto itr = m_entries.find(filepath);
+		if (itr != m_entries.end() && itr->second.mtime == mtime && itr->second.size == size)
+		{
+			++m_hit_count;
+			return itr->second.file;
+		}
+	}
+
+	++m_miss_count;
+
+	std::ifstream fin(filepath, std::ios::binary);
+	if (!fin.is_open()) {
+		return nullptr;
+	}
+	std::stringstream buffer;
+	buffer << fin.rdbuf();
+
+	Entry entry;
+	entry.mtime = mtime;
+	entry.size  = size;
+	entry.file  = Parse(buffer.str());
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_entries[filepath] = entry;
+	return entry.file;
+}
+
+void IncludeCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_entries.clear();
+
+	m_hit_count = 0;
+	m_miss_count = 0;
+}
+
+std::shared_ptr<IncludeCache::File> IncludeCache::Parse(std::string_view text)
+{
+	auto file = std::make_shared<File>();
+	file->hash = Hasher().Update(text).Digest();
+
+	// the first two lines that aren't blank or comments and the #if
+	// nesting, for the include guard check: the #ifndef on the first line
+	// must be closed by the last one, with no #else or #elif between
+	std::vector<std::string_view> head;
+	int depth = 0;
+	bool guarded = true, closed = false;
+
+	std::string chunk;
+	chunk.reserve(text.size());
+
+	LineScanner scanner(text);
+	std::string_view line;
+	while (scanner.Next(line))
+	{
+		auto trimmed = LineScanner::Trim(line);
+		if (!trimmed.empty() && trimmed.substr(0, 2) != "//")
+		{
+			if (head.size() < 2) {
+				head.push_back(trimmed);
+			}
+
+			std::string_view cond;
+			if (closed || (head.size() == 1 && depth == 0 && !get_directive(trimmed, "ifndef", cond))) {
+				guarded = false;
+			} else if (get_directive(trimmed, "if", cond) || get_directive(trimmed, "ifdef", cond) ||
+				       get_directive(trimmed, "ifndef", cond)) {
+				++depth;
+			} else if (get_directive(trimmed, "endif", cond)) {
+				closed = --depth == 0;
+			} else if (depth == 1 && (get_directive(trimmed, "else", cond) || get_directive(trimmed, "elif", cond) ||
+				       get_directive(trimmed, "elifdef", cond) || get_directive(trimmed, "elifndef", cond))) {
+				guarded = false;
+			}
+		}
+
+		std::string_view rest;
+		if (get_directive(trimmed, "include", rest) && rest.size() >= 2)
+		{
+			const char close = rest[0] == '<' ? '>' : '"';
+			auto path_end = rest.find(close, 1);
+			if ((rest[0] == '"' || rest[0] == '<') && path_end != std::string_view::npos)
+			{
+				Include inc;
+				inc.path   = std::string(rest.substr(1, path_end - 1));
+				inc.system = rest[0] == '<';
+				file->includes.push_back(inc);
+				file->chunks.push_back(std::move(chunk));
+				chunk.clear();
+				continue;
+			}
+		}
+		else if (get_directive(trimmed, "pragma", rest) && first_token(rest) == "once")
+		{
+			file->once = true;
+			continue;
+		}
+
+		chunk.append(line.data(), line.size());
+		chunk.push_back('\n');
+	}
+	file->chunks.push_back(std::move(chunk));
+
+	std::string_view guard, define;
+	if (guarded && closed && head.size() == 2 &&
+		get_directive(head[0], "ifndef", guard) &&
+		get_directive(head[1], "define", define) &&
+		!guard.empty() && first_token(guard) == first_token(define)) {
+		file->once = true;
+	}
+
+	return file;
+}
+
+}
\ No newline at end of file
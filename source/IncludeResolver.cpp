@@ -0,0 +1,182 @@
+#include "shadertrans/IncludeResolver.h"
+#include "shadertrans/Hasher.h"
+
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+#include <iterator>
+
+namespace
+{
+
+std::string normalize(const std::filesystem::path& path)
+{
+	std::error_code ec;
+	auto ret = std::filesystem::weakly_canonical(path, ec);
+	return (ec ? path.lexically_normal() : ret).generic_string();
+}
+
+bool is_file(const std::filesystem::path& path)
+{
+	std::error_code ec;
+	return std::filesystem::is_regular_file(path, ec);
+}
+
+void write_escaped(std::ostream& out, const std::string& path)
+{
+	for (auto c : path)
+	{
+		switch (c)
+		{
+		case ' ':
+		case '#':
+			out << '\\' << c;
+			break;
+		case '$':
+			out << "$$";
+			break;
+		default:
+			out << c;
+		}
+	}
+}
+
+}
+
+namespace shadertrans
+{
+
+IncludeResolver::IncludeResolver(const std::vector<std::string>& search_paths)
+	: m_search_paths(search_paths)
+{
+}
+
+std::string IncludeResolver::Resolve(std::string_view source_code, const std::string& source_path)
+{
+	m_once.clear();
+	m_stack.clear();
+	m_deps.clear();
+	m_dep_paths.clear();
+
+	auto file = IncludeCache::Parse(source_code);
+
+	std::string dir;
+	if (!source_path.empty())
+	{
+		auto path = normalize(source_path);
+		m_stack.push_back(path);
+		dir = std::filesystem::path(path).parent_path().generic_string();
+
+		m_deps.push_back({ path, file->hash });
+		m_dep_paths.insert(path);
+	}
+	if (file->once && !m_stack.empty()) {
+		m_once.insert(m_stack.back());
+	}
+
+	std::string out;
+	out.reserve(source_code.size());
+	Expand(*file, dir, out);
+
+	return out;
+}
+
+std::string IncludeResolver::Find(const IncludeCache::Include& include, const std::string& from_dir) const
+{
+	std::filesystem::path path(include.path);
+	if (path.is_absolute()) {
+		return is_file(path) ? normalize(path) : "";
+	}
+
+	if (!include.system && !from_dir.empty())
+	{
+		auto full = std::filesystem::path(from_dir) / path;
+		if (is_file(full)) {
+			return normalize(full);
+		}
+	}
+
+	for (auto& search_path : m_search_paths)
+	{
+		auto full = std::filesystem::path(search_path) / path;
+		if (is_file(full)) {
+			return normalize(full);
+		}
+	}
+
+	return is_file(path) ? normalize(path) : "";
+}
+
+void IncludeResolver::Expand(const IncludeCache::File& file, const std::string& dir, std::string& out)
+{
+	for (size_t i = 0, n = file.includes.size(); i < n; ++i)
+	{
+		out += file.chunks[i];
+
+		auto path = Find(file.includes[i], dir);
+		if (path.empty() || m_once.find(path) != m_once.end() ||
+			std::find(m_stack.begin(), m_stack.end(), path) != m_stack.end()) {
+			continue;
+		}
+
+		auto inc = IncludeCache::Instance().Load(path);
+		if (!inc) {
+			continue;
+		}
+		if (m_dep_paths.insert(path).second) {
+			m_deps.push_back({ path, inc->hash });
+		}
+		if (inc->once) {
+			m_once.insert(path);
+		}
+
+		m_stack.push_back(path);
+		Expand(*inc, std::filesystem::path(path).parent_path().generic_string(), out);
+		m_stack.pop_back();
+	}
+	out += file.chunks.back();
+}
+
+bool IncludeResolver::IsUpToDate(const std::vector<Dependency>& deps)
+{
+	// read and hash the files themselves, the IncludeCache would trust an
+	// unchanged mtime and size
+	for (auto& dep : deps)
+	{
+		std::ifstream fin(dep.path, std::ios::binary);
+		if (!fin.is_open()) {
+			return false;
+		}
+		const std::string text((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+		if (Hasher().Update(text).Digest() != dep.hash) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void IncludeResolver::WriteDepfile(std::ostream& out, const std::string& target,
+	                               const std::vector<Dependency>& deps)
+{
+	write_escaped(out, target);
+	out << ":";
+	for (auto& dep : deps)
+	{
+		out << " \\\n  ";
+		write_escaped(out, dep.path);
+	}
+	out << "\n";
+}
+
+bool IncludeResolver::WriteDepfile(const std::string& filepath, const std::string& target,
+	                               const std::vector<Dependency>& deps)
+{
+	std::ofstream fout(filepath, std::ios::trunc);
+	if (!fout.is_open()) {
+		return false;
+	}
+	WriteDepfile(fout, target, deps);
+	return static_cast<bool>(fout);
+}
+
+}
\ No newline at end of file
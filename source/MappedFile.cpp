@@ -0,0 +1,81 @@
+#include "shadertrans/MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace shadertrans
+{
+
+MappedFile::MappedFile(const std::string& filepath)
+{
+#ifdef _WIN32
+	HANDLE file = ::CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return;
+	}
+	m_file = file;
+
+	LARGE_INTEGER size;
+	if (!::GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+		return;
+	}
+
+	HANDLE mapping = ::CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping) {
+		return;
+	}
+	m_mapping = mapping;
+
+	m_data = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (m_data) {
+		m_size = static_cast<size_t>(size.QuadPart);
+	}
+#else
+	int fd = ::open(filepath.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return;
+	}
+
+	struct stat st;
+	if (::fstat(fd, &st) == 0 && st.st_size > 0)
+	{
+		void* data = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data != MAP_FAILED) {
+			m_data = data;
+			m_size = static_cast<size_t>(st.st_size);
+		}
+	}
+
+	// the mapping stays valid after the descriptor is closed
+	::close(fd);
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef _WIN32
+	if (m_data) {
+		::UnmapViewOfFile(m_data);
+	}
+	if (m_mapping) {
+		::CloseHandle(m_mapping);
+	}
+	if (m_file) {
+		::CloseHandle(m_file);
+	}
+#else
+	if (m_data) {
+		::munmap(const_cast<void*>(m_data), m_size);
+	}
+#endif
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,289 @@
+#include "shadertrans/ReflectionBinary.h"
+#include "shadertrans/MappedFile.h"
+
+#include <unordered_map>
+#include <fstream>
+
+#include <string.h>
+
+namespace
+{
+
+class StringBlob
+{
+public:
+	StringBlob() { m_data.push_back(0); }
+
+	uint32_t Add(std::string_view str)
+	{
+		if (str.empty()) {
+			return 0;
+		}
+
+		auto itr = m_offsets.find(str);
+		if (itr != m_offsets.end()) {
+			return itr->second;
+		}
+
+		const uint32_t offset = static_cast<uint32_t>(m_data.size());
+		m_data.insert(m_data.end(), str.begin(), str.end());
+		m_data.push_back(0);
+		m_offsets.insert({ str, offset });
+		return offset;
+	}
+
+	const std::vector<char>& Data() const { return m_data; }
+
+private:
+	std::vector<char> m_data;
+
+	// views into the caller's strings, which outlive the blob
+	std::unordered_map<std::string_view, uint32_t> m_offsets;
+
+}; // StringBlob
+
+// the last VarType, anything above it didn't come from Write
+const uint32_t MAX_VAR_TYPE = static_cast<uint32_t>(shadertrans::ShaderReflection::VarType::StorageBuffer);
+
+bool check_variable(const shadertrans::ReflectionBinary::Variable& var, uint32_t variable_count)
+{
+	return var.type <= MAX_VAR_TYPE
+		&& uint64_t(var.first_child) + var.child_count <= variable_count;
+}
+
+template <typename T>
+void append(std::vector<uint8_t>& out, const T* data, size_t count)
+{
+	auto bytes = reinterpret_cast<const uint8_t*>(data);
+	out.insert(out.end(), bytes, bytes + sizeof(T) * count);
+}
+
+}
+
+namespace shadertrans
+{
+
+void ReflectionBinary::Write(const ReflectionContext& ctx, const ReflectionContext::UniformTable& uniforms,
+	                         const std::vector<std::pair<std::string, ShaderReflection::Function>>& funcs,
+	                         std::vector<uint8_t>& out)
+{
+	StringBlob strings;
+
+	std::vector<Variable> variables;
+	variables.reserve(uniforms.variables.size());
+	for (auto& src : uniforms.variables)
+	{
+		Variable dst;
+		dst.name          = strings.Add(ctx.GetName(src.name));
+		dst.type          = static_cast<uint32_t>(src.type);
+		dst.binding       = src.binding;
+		dst.offset        = src.offset;
+		dst.size          = src.size;
+		dst.array_stride  = src.array_stride;
+		dst.matrix_stride = src.matrix_stride;
+		dst.array_size    = src.array_size;
+		dst.parent        = src.parent;
+		dst.first_child   = src.first_child;
+		dst.child_count   = src.child_count;
+		variables.push_back(dst);
+	}
+
+	std::vector<Function> functions;
+	std::vector<Variable> arguments;
+	functions.reserve(funcs.size());
+	for (auto& src : funcs)
+	{
+		Function dst;
+		dst.name           = strings.Add(src.first);
+		dst.ret_type       = static_cast<uint32_t>(src.second.ret_type.type);
+		dst.first_argument = static_cast<uint32_t>(arguments.size());
+		dst.argument_count = static_cast<uint32_t>(src.second.arguments.size());
+		functions.push_back(dst);
+
+		for (auto& arg : src.second.arguments)
+		{
+			Variable var;
+			memset(&var, 0, sizeof(var));
+			var.name   = strings.Add(arg.name);
+			var.type   = static_cast<uint32_t>(arg.type);
+			var.parent = NO_PARENT;
+			arguments.push_back(var);
+		}
+	}
+
+	auto& blob = strings.Data();
+
+	Header header;
+	header.magic          = MAGIC;
+	header.version        = VERSION;
+	header.root_count     = uniforms.root_count;
+	header.variable_count = static_cast<uint32_t>(variables.size());
+	header.function_count = static_cast<uint32_t>(functions.size());
+	header.argument_count = static_cast<uint32_t>(arguments.size());
+	header.string_bytes   = static_cast<uint32_t>(blob.size());
+	header.reserved       = 0;
+
+	out.clear();
+	out.reserve(sizeof(Header) + sizeof(Variable) * (variables.size() + arguments.size())
+		+ sizeof(Function) * functions.size() + blob.size() + 3);
+	append(out, &header, 1);
+	append(out, variables.data(), variables.size());
+	append(out, functions.data(), functions.size());
+	append(out, arguments.data(), arguments.size());
+	append(out, blob.data(), blob.size());
+
+	// keep files concatenated or packed after this one aligned
+	out.resize((out.size() + 3) & ~size_t(3), 0);
+}
+
+bool ReflectionBinary::Write(const ReflectionContext& ctx, const ReflectionContext::UniformTable& uniforms,
+	                         const std::vector<std::pair<std::string, ShaderReflection::Function>>& funcs,
+	                         const std::string& filepath)
+{
+	std::vector<uint8_t> data;
+	Write(ctx, uniforms, funcs, data);
+
+	std::ofstream fout(filepath, std::ios::binary | std::ios::trunc);
+	if (!fout.is_open()) {
+		return false;
+	}
+	fout.write(reinterpret_cast<const char*>(data.data()), data.size());
+	return static_cast<bool>(fout);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// class ReflectionBinary::View
+//////////////////////////////////////////////////////////////////////////
+
+bool ReflectionBinary::View::Open(const void* data, size_t size)
+{
+	m_header = nullptr;
+
+	if (!data || size < sizeof(Header) || reinterpret_cast<uintptr_t>(data) % 4 != 0) {
+		return false;
+	}
+
+	auto header = static_cast<const Header*>(data);
+	if (header->magic != MAGIC || header->version != VERSION) {
+		return false;
+	}
+
+	const uint64_t total = sizeof(Header)
+		+ uint64_t(sizeof(Variable)) * header->variable_count
+		+ uint64_t(sizeof(Function)) * header->function_count
+		+ uint64_t(sizeof(Variable)) * header->argument_count
+		+ header->string_bytes;
+	if (total > size || header->root_count > header->variable_count) {
+		return false;
+	}
+
+	auto ptr = static_cast<const uint8_t*>(data) + sizeof(Header);
+	auto variables = reinterpret_cast<const Variable*>(ptr);
+	ptr += sizeof(Variable) * header->variable_count;
+	auto functions = reinterpret_cast<const Function*>(ptr);
+	ptr += sizeof(Function) * header->function_count;
+	auto arguments = reinterpret_cast<const Variable*>(ptr);
+	ptr += sizeof(Variable) * header->argument_count;
+	auto strings = reinterpret_cast<const char*>(ptr);
+
+	// ranges only, so that walking the tree can't leave the buffer
+	if (header->string_bytes == 0 || strings[header->string_bytes - 1] != 0) {
+		return false;
+	}
+	for (uint32_t i = 0; i < header->variable_count; ++i)
+	{
+		auto& var = variables[i];
+		if (!check_variable(var, header->variable_count) ||
+			(var.child_count > 0 && var.first_child <= i)) {
+			return false;
+		}
+	}
+	// arguments point into the variables table, which only points forward
+	for (uint32_t i = 0; i < header->argument_count; ++i)
+	{
+		if (!check_variable(arguments[i], header->variable_count)) {
+			return false;
+		}
+	}
+	for (uint32_t i = 0; i < header->function_count; ++i)
+	{
+		auto& func = functions[i];
+		if (uint64_t(func.first_argument) + func.argument_count > header->argument_count ||
+			func.ret_type > MAX_VAR_TYPE) {
+			return false;
+		}
+	}
+
+	m_header    = header;
+	m_variables = variables;
+	m_functions = functions;
+	m_arguments = arguments;
+	m_strings   = strings;
+
+	return true;
+}
+
+bool ReflectionBinary::View::OpenFile(const std::string& filepath)
+{
+	auto file = std::make_shared<MappedFile>(filepath);
+	if (!file->IsValid() || !Open(file->Data(), file->Size())) {
+		return false;
+	}
+
+	m_file = file;
+	return true;
+}
+
+const ReflectionBinary::Function* 
+ReflectionBinary::View::FindFunction(std::string_view name) const
+{
+	for (uint32_t i = 0, n = m_header->function_count; i < n; ++i) {
+		if (GetName(m_functions[i].name) == name) {
+			return &m_functions[i];
+		}
+	}
+	return nullptr;
+}
+
+void ReflectionBinary::View::GetUniforms(std::vector<ShaderReflection::Variable>& uniforms) const
+{
+	for (uint32_t i = 0; i < m_header->root_count; ++i) {
+		uniforms.push_back(ToVariable(m_variables[i]));
+	}
+}
+
+bool ReflectionBinary::View::GetFunction(std::string_view name, ShaderReflection::Function& func) const
+{
+	auto f = FindFunction(name);
+	if (!f) {
+		return false;
+	}
+
+	func.ret_type.type = static_cast<ShaderReflection::VarType>(f->ret_type);
+	for (uint32_t i = 0; i < f->argument_count; ++i) {
+		func.arguments.push_back(ToVariable(m_arguments[f->first_argument + i]));
+	}
+	return true;
+}
+
+ShaderReflection::Variable ReflectionBinary::View::ToVariable(const Variable& var) const
+{
+	ShaderReflection::Variable ret;
+	ret.name          = std::string(GetName(var.name));
+	ret.type          = static_cast<ShaderReflection::VarType>(var.type);
+	ret.binding       = var.binding;
+	ret.offset        = var.offset;
+	ret.size          = var.size;
+	ret.array_stride  = var.array_stride;
+	ret.matrix_stride = var.matrix_stride;
+	ret.array_size    = var.array_size;
+
+	ret.children.reserve(var.child_count);
+	for (uint32_t i = 0; i < var.child_count; ++i) {
+		ret.children.push_back(ToVariable(m_variables[var.first_child + i]));
+	}
+
+	return ret;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,54 @@
+#include "shadertrans/ReflectionContext.h"
+#include "shadertrans/spirv_Reflection.h"
+
+namespace shadertrans
+{
+
+void ReflectionContext::GetUniforms(SpirvSpan spirv, UniformTable& table, bool compact_arrays)
+{
+	spirv::Reflection::GetUniforms(spirv, *this, table, compact_arrays);
+}
+
+void ReflectionContext::Flatten(const std::vector<ShaderReflection::Variable>& uniforms, UniformTable& table)
+{
+	table.variables.clear();
+	table.root_count = static_cast<uint32_t>(uniforms.size());
+
+	// breadth first, so that siblings end up next to each other
+	std::vector<const ShaderReflection::Variable*> src;
+	for (auto& var : uniforms) {
+		src.push_back(&var);
+	}
+	table.variables.resize(src.size());
+
+	for (size_t i = 0; i < src.size(); ++i)
+	{
+		auto& from = *src[i];
+
+		// no reference into table.variables, it grows below
+		Variable to = table.variables[i];
+		to.name          = m_names.Intern(from.name);
+		to.type          = from.type;
+		to.binding       = from.binding;
+		to.offset        = from.offset;
+		to.size          = from.size;
+		to.array_stride  = from.array_stride;
+		to.matrix_stride = from.matrix_stride;
+		to.array_size    = from.array_size;
+
+		to.first_child = static_cast<uint32_t>(src.size());
+		to.child_count = static_cast<uint32_t>(from.children.size());
+		for (auto& child : from.children)
+		{
+			src.push_back(&child);
+
+			Variable v;
+			v.parent = static_cast<uint32_t>(i);
+			table.variables.push_back(v);
+		}
+
+		table.variables[i] = to;
+	}
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,219 @@
+#include "shadertrans/ShaderArchive.h"
+#include "shadertrans/MappedFile.h"
+#include "shadertrans/Hasher.h"
+
+#include <algorithm>
+#include <fstream>
+
+#include <string.h>
+
+namespace
+{
+
+void align_to(std::vector<uint8_t>& out, size_t alignment)
+{
+	out.resize((out.size() + alignment - 1) / alignment * alignment, 0);
+}
+
+void append(std::vector<uint8_t>& out, const void* data, size_t size)
+{
+	auto bytes = static_cast<const uint8_t*>(data);
+	out.insert(out.end(), bytes, bytes + size);
+}
+
+}
+
+namespace shadertrans
+{
+
+uint64_t ShaderArchive::HashName(std::string_view name)
+{
+	return Hasher().Update(name.data(), name.size()).Digest();
+}
+
+//////////////////////////////////////////////////////////////////////////
+// class ShaderArchive::Writer
+//////////////////////////////////////////////////////////////////////////
+
+bool ShaderArchive::Writer::Add(const std::string& name, SpirvSpan spirv, const std::vector<uint8_t>& reflection)
+{
+	if (!m_names.insert(name).second) {
+		return false;
+	}
+
+	Item item;
+	item.name = name;
+	item.spirv = spirv.ToVector();
+	item.reflection = reflection;
+	m_items.push_back(std::move(item));
+
+	return true;
+}
+
+void ShaderArchive::Writer::Write(std::vector<uint8_t>& out) const
+{
+	std::vector<const Item*> items;
+	for (auto& item : m_items) {
+		items.push_back(&item);
+	}
+	std::stable_sort(items.begin(), items.end(), [](const Item* a, const Item* b) {
+		return HashName(a->name) < HashName(b->name);
+	});
+
+	out.clear();
+	out.resize(sizeof(Header) + sizeof(Entry) * items.size(), 0);
+
+	std::vector<Entry> entries(items.size());
+	std::vector<char> names;
+	for (size_t i = 0; i < items.size(); ++i)
+	{
+		auto& item = *items[i];
+		auto& e = entries[i];
+		memset(&e, 0, sizeof(e));
+
+		e.hash = HashName(item.name);
+		e.name = static_cast<uint32_t>(names.size());
+		names.insert(names.end(), item.name.begin(), item.name.end());
+		names.push_back(0);
+
+		align_to(out, 8);
+		e.spirv_offset = out.size();
+		e.spirv_words  = item.spirv.size();
+		append(out, item.spirv.data(), item.spirv.size() * sizeof(unsigned int));
+
+		if (!item.reflection.empty())
+		{
+			align_to(out, 8);
+			e.reflection_offset = out.size();
+			e.reflection_bytes  = item.reflection.size();
+			append(out, item.reflection.data(), item.reflection.size());
+		}
+	}
+
+	Header header;
+	header.magic        = MAGIC;
+	header.version      = VERSION;
+	header.entry_count  = static_cast<uint32_t>(entries.size());
+	header.names_bytes  = static_cast<uint32_t>(names.size());
+	header.names_offset = out.size();
+	append(out, names.data(), names.size());
+	align_to(out, 8);
+
+	memcpy(out.data(), &header, sizeof(header));
+	if (!entries.empty()) {
+		memcpy(out.data() + sizeof(header), entries.data(), sizeof(Entry) * entries.size());
+	}
+}
+
+bool ShaderArchive::Writer::Write(const std::string& filepath) const
+{
+	std::vector<uint8_t> data;
+	Write(data);
+
+	std::ofstream fout(filepath, std::ios::binary | std::ios::trunc);
+	if (!fout.is_open()) {
+		return false;
+	}
+	fout.write(reinterpret_cast<const char*>(data.data()), data.size());
+	return static_cast<bool>(fout);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// class ShaderArchive::Reader
+//////////////////////////////////////////////////////////////////////////
+
+bool ShaderArchive::Reader::Open(const std::string& filepath)
+{
+	auto file = std::make_shared<MappedFile>(filepath);
+	if (!file->IsValid() || !Open(file->Data(), file->Size())) {
+		return false;
+	}
+
+	m_file = file;
+	return true;
+}
+
+bool ShaderArchive::Reader::Open(const void* data, size_t size)
+{
+	m_header = nullptr;
+	m_file.reset();
+
+	if (!data || size < sizeof(Header) || reinterpret_cast<uintptr_t>(data) % 8 != 0) {
+		return false;
+	}
+
+	auto bytes = static_cast<const uint8_t*>(data);
+	auto header = reinterpret_cast<const Header*>(bytes);
+	if (header->magic != MAGIC || header->version != VERSION) {
+		return false;
+	}
+	if (sizeof(Header) + uint64_t(sizeof(Entry)) * header->entry_count > size ||
+		header->names_offset > size || header->names_bytes > size - header->names_offset ||
+		(header->entry_count > 0 && (header->names_bytes == 0 || bytes[header->names_offset + header->names_bytes - 1] != 0))) {
+		return false;
+	}
+
+	auto entries = reinterpret_cast<const Entry*>(bytes + sizeof(Header));
+	for (uint32_t i = 0; i < header->entry_count; ++i)
+	{
+		auto& e = entries[i];
+		if (e.name >= header->names_bytes ||
+			e.spirv_offset % 4 != 0 || e.spirv_offset > size || e.spirv_words > (size - e.spirv_offset) / 4 ||
+			e.reflection_offset > size || e.reflection_bytes > size - e.reflection_offset) {
+			return false;
+		}
+	}
+
+	m_data    = bytes;
+	m_header  = header;
+	m_entries = entries;
+	m_names   = reinterpret_cast<const char*>(bytes + header->names_offset);
+
+	return true;
+}
+
+std::string_view ShaderArchive::Reader::GetName(size_t idx) const
+{
+	return idx < Size() ? std::string_view(m_names + m_entries[idx].name) : std::string_view();
+}
+
+SpirvSpan ShaderArchive::Reader::GetSpirv(size_t idx) const
+{
+	if (idx >= Size()) {
+		return SpirvSpan();
+	}
+
+	auto& e = m_entries[idx];
+	return SpirvSpan(reinterpret_cast<const unsigned int*>(m_data + e.spirv_offset), static_cast<size_t>(e.spirv_words));
+}
+
+bool ShaderArchive::Reader::GetReflection(size_t idx, ReflectionBinary::View& view) const
+{
+	if (idx >= Size() || m_entries[idx].reflection_bytes == 0) {
+		return false;
+	}
+
+	auto& e = m_entries[idx];
+	return view.Open(m_data + e.reflection_offset, static_cast<size_t>(e.reflection_bytes));
+}
+
+size_t ShaderArchive::Reader::Find(std::string_view name) const
+{
+	if (!m_header) {
+		return 0;
+	}
+
+	const uint64_t hash = HashName(name);
+	auto begin = m_entries, end = m_entries + m_header->entry_count;
+	auto itr = std::lower_bound(begin, end, hash, [](const Entry& e, uint64_t hash) {
+		return e.hash < hash;
+	});
+	for (; itr != end && itr->hash == hash; ++itr) {
+		if (name == m_names + itr->name) {
+			return itr - begin;
+		}
+	}
+	return Size();
+}
+
+}
\ No newline at end of file
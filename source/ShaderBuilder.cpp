@@ -174,7 +174,7 @@ const char* ShaderBuilder::QueryUniformName(const spvgentwo::Instruction* unif)
 }
 
 std::shared_ptr<ShaderBuilder::Module> 
-ShaderBuilder::AddModule(ShaderStage stage, const std::string& _code, const std::string& lang, const std::string& name, const std::string& entry_point)
+ShaderBuilder::AddModule(ShaderStage stage, std::string_view _code, const std::string& lang, const std::string& name, const std::string& entry_point)
 {
 	auto module = FindModule(name);
 	if (module) {
@@ -217,9 +217,11 @@ ShaderBuilder::AddModule(ShaderStage stage, const std::string& _code, const std:
 		module->includes.push_back(inc_module);
 	}
 #else
-	std::string code = _code;
+	std::string prepared;
+	std::string_view code = _code;
 	if (lang == "glsl") {
-		code = ShaderPreprocess::PrepareGLSL(stage, code);
+		prepared = ShaderPreprocess::PrepareGLSL(stage, _code);
+		code = prepared;
 	}
 #endif // UNIQUE_INCLUDE_MODULE
 
@@ -297,12 +299,16 @@ void ShaderBuilder::AddLinkDecl(spvgentwo::Function* func, const std::string& na
 	}
 }
 
-std::vector<uint32_t> ShaderBuilder::Link()
+std::vector<uint32_t> ShaderBuilder::Link(const SpirvTools::OptimizeOptions& optimize)
 {
 	m_main->assignIDs(m_gram.get());
 
-	return LinkSpvtools();
-	//return LinkSpvgentwo();
+	auto spv = LinkSpvtools();
+	//auto spv = LinkSpvgentwo();
+	if (!spv.empty() && !SpirvTools::Optimize(spv, optimize)) {
+		spv.clear();
+	}
+	return spv;
 }
 
 std::string ShaderBuilder::ConnectCSMain(const std::string& main_glsl)
@@ -401,50 +407,25 @@ std::vector<uint32_t> ShaderBuilder::LinkSpvtools()
 {
 	ResetState();
 
-	const spvtools::MessageConsumer consumer = [](spv_message_level_t level,
-        const char*,
-        const spv_position_t& position,
-        const char* message) {
-            switch (level) {
-            case SPV_MSG_FATAL:
-            case SPV_MSG_INTERNAL_ERROR:
-            case SPV_MSG_ERROR:
-                std::cerr << "error: " << position.index << ": " << message
-                    << std::endl;
-                break;
-            case SPV_MSG_WARNING:
-                std::cout << "warning: " << position.index << ": " << message
-                    << std::endl;
-                break;
-            case SPV_MSG_INFO:
-                std::cout << "info: " << position.index << ": " << message << std::endl;
-                break;
-            default:
-                break;
-            }
-    };
-	spvtools::Context context(SPV_ENV_UNIVERSAL_1_5);
-	context.SetMessageConsumer(consumer);
-
     std::vector<std::vector<unsigned int>> contents;
     for (auto& module : m_modules)
 	{
 		std::vector<unsigned int> spv;
 		spvgentwo::BinaryVectorWriter writer(spv);
 		module->impl->write(writer);
-        contents.emplace_back(spv);
+        contents.emplace_back(std::move(spv));
     }
 	{
 		std::vector<unsigned int> spv;
 		spvgentwo::BinaryVectorWriter writer(spv);
 		m_main->write(writer);
-		contents.emplace_back(spv);
+		contents.emplace_back(std::move(spv));
 	}
 
     spvtools::LinkerOptions options;
 
 	std::vector<uint32_t> spv;
-	spv_result_t status = spvtools::Link(context, contents, &spv, options);
+	spv_result_t status = spvtools::Link(SpirvTools::LinkContext(), contents, &spv, options);
 	if (spv.empty()) {
 		return spv;
 	}
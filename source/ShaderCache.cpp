@@ -0,0 +1,50 @@
+#include "shadertrans/ShaderCache.h"
+
+namespace shadertrans
+{
+
+ShaderCache& ShaderCache::Instance()
+{
+	static ShaderCache instance;
+	return instance;
+}
+
+bool ShaderCache::Query(uint64_t key, std::vector<unsigned int>& spirv)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto itr = m_entries.find(key);
+		if (itr != m_entries.end())
+		{
+			spirv = itr->second;
+			++m_hit_count;
+			return true;
+		}
+	}
+
+	++m_miss_count;
+	return false;
+}
+
+void ShaderCache::Insert(uint64_t key, const std::vector<unsigned int>& spirv)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_entries[key] = spirv;
+}
+
+void ShaderCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_entries.clear();
+
+	m_hit_count = 0;
+	m_miss_count = 0;
+}
+
+size_t ShaderCache::GetEntryCount() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_entries.size();
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,338 @@
+#include "shadertrans/ShaderDiskCache.h"
+#include "shadertrans/Hasher.h"
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <algorithm>
+#include <chrono>
+
+#include <string.h>
+
+namespace
+{
+
+const uint32_t ENTRY_MAGIC = 0x43445453; // "STDC"
+
+// a writer renames its temp file as soon as it is written
+const auto STALE_TMP_AGE = std::chrono::minutes(10);
+
+struct EntryHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t key;
+	uint64_t size;
+	uint64_t checksum;
+};
+
+std::string key_to_hex(uint64_t key)
+{
+	static const char* digits = "0123456789abcdef";
+
+	std::string ret(16, '0');
+	for (int i = 15; i >= 0; --i, key >>= 4) {
+		ret[i] = digits[key & 0xf];
+	}
+	return ret;
+}
+
+uint64_t dir_size(const std::filesystem::path& dir)
+{
+	uint64_t size = 0;
+	std::error_code ec;
+	for (std::filesystem::recursive_directory_iterator itr(dir, ec), end; !ec && itr != end; itr.increment(ec))
+	{
+		if (itr->is_regular_file(ec)) {
+			size += itr->file_size(ec);
+		}
+	}
+	return size;
+}
+
+}
+
+namespace shadertrans
+{
+
+ShaderDiskCache& ShaderDiskCache::Instance()
+{
+	static ShaderDiskCache instance;
+	return instance;
+}
+
+void ShaderDiskCache::SetRoot(const std::string& root, uint64_t max_bytes)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_enable = false;
+	if (root.empty()) {
+		m_dir.clear();
+		return;
+	}
+
+	auto dir = std::filesystem::path(root) / ("v" + std::to_string(FORMAT_VERSION));
+
+	std::error_code ec;
+	std::filesystem::create_directories(dir, ec);
+	if (ec) {
+		return;
+	}
+
+	m_dir = dir.string();
+	m_max_bytes = max_bytes;
+	m_curr_bytes = dir_size(dir);
+
+	// different processes may share the directory, keep temp names apart
+	m_tmp_id = std::random_device()();
+
+	m_enable = true;
+}
+
+bool ShaderDiskCache::Load(uint64_t key, std::vector<unsigned int>& spirv)
+{
+	std::string payload;
+	if (!ReadEntry(key, payload) || payload.size() % sizeof(unsigned int) != 0) {
+		return false;
+	}
+
+	spirv.resize(payload.size() / sizeof(unsigned int));
+	memcpy(spirv.data(), payload.data(), payload.size());
+	return true;
+}
+
+bool ShaderDiskCache::Load(uint64_t key, std::string& text)
+{
+	return ReadEntry(key, text);
+}
+
+void ShaderDiskCache::Store(uint64_t key, const std::vector<unsigned int>& spirv)
+{
+	WriteEntry(key, spirv.data(), spirv.size() * sizeof(unsigned int));
+}
+
+void ShaderDiskCache::Store(uint64_t key, const std::string& text)
+{
+	WriteEntry(key, text.data(), text.size());
+}
+
+void ShaderDiskCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_dir.empty()) {
+		return;
+	}
+
+	std::error_code ec;
+	for (std::filesystem::directory_iterator itr(m_dir, ec), end; !ec && itr != end; itr.increment(ec)) {
+		std::filesystem::remove_all(itr->path(), ec);
+	}
+	m_curr_bytes = 0;
+
+	m_hit_count = 0;
+	m_miss_count = 0;
+}
+
+std::string ShaderDiskCache::EntryPath(uint64_t key) const
+{
+	auto hex = key_to_hex(key);
+	return (std::filesystem::path(m_dir) / hex.substr(0, 2) / (hex + ".bin")).string();
+}
+
+bool ShaderDiskCache::ReadEntry(uint64_t key, std::string& payload)
+{
+	std::string path;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_enable) {
+			return false;
+		}
+		path = EntryPath(key);
+	}
+
+	std::ifstream fin(path, std::ios::binary);
+	if (!fin.is_open()) {
+		++m_miss_count;
+		return false;
+	}
+
+	std::error_code ec;
+	const uint64_t file_size = std::filesystem::file_size(path, ec);
+
+	// the size field is checked against the file before it sizes any
+	// allocation, a corrupt or foreign entry is a miss and gets dropped
+	EntryHeader header;
+	if (ec || !fin.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+		header.magic != ENTRY_MAGIC || header.version != FORMAT_VERSION || header.key != key ||
+		header.size != file_size - sizeof(header)) {
+		fin.close();
+		RemoveEntry(path);
+		++m_miss_count;
+		return false;
+	}
+
+	payload.resize(static_cast<size_t>(header.size));
+	if (!fin.read(payload.data(), payload.size()) ||
+		Hasher().Update(payload.data(), payload.size()).Digest() != header.checksum) {
+		fin.close();
+		RemoveEntry(path);
+		++m_miss_count;
+		return false;
+	}
+	fin.close();
+
+	// lru: the mtime is the last access time
+	std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+
+	++m_hit_count;
+	return true;
+}
+
+void ShaderDiskCache::RemoveEntry(const std::string& path)
+{
+	std::error_code ec;
+	const uint64_t size = std::filesystem::file_size(path, ec);
+	if (ec || !std::filesystem::remove(path, ec)) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_curr_bytes -= std::min(m_curr_bytes, size);
+}
+
+void ShaderDiskCache::WriteEntry(uint64_t key, const void* data, size_t size)
+{
+	std::string path;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_enable) {
+			return;
+		}
+		path = EntryPath(key);
+	}
+
+	std::error_code ec;
+	std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+
+	EntryHeader header;
+	header.magic    = ENTRY_MAGIC;
+	header.version  = FORMAT_VERSION;
+	header.key      = key;
+	header.size     = size;
+	header.checksum = Hasher().Update(data, size).Digest();
+
+	auto tmp_path = path + "." + std::to_string(m_tmp_id++) + ".tmp";
+	{
+		std::ofstream fout(tmp_path, std::ios::binary | std::ios::trunc);
+		if (!fout.is_open()) {
+			return;
+		}
+		fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		fout.write(static_cast<const char*>(data), size);
+		if (!fout) {
+			fout.close();
+			std::filesystem::remove(tmp_path, ec);
+			return;
+		}
+	}
+
+	// an overwritten entry already counts towards m_curr_bytes
+	uint64_t replaced = std::filesystem::file_size(path, ec);
+	if (ec) {
+		replaced = 0;
+	}
+
+	std::filesystem::rename(tmp_path, path, ec);
+	if (ec) {
+		std::filesystem::remove(tmp_path, ec);
+		return;
+	}
+
+	bool over_budget = false;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_curr_bytes -= std::min(m_curr_bytes, replaced);
+		m_curr_bytes += sizeof(header) + size;
+		over_budget = m_curr_bytes > m_max_bytes;
+	}
+	if (over_budget) {
+		Evict();
+	}
+}
+
+void ShaderDiskCache::Evict()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	struct Entry
+	{
+		std::filesystem::path path;
+		std::filesystem::file_time_type time;
+		uint64_t size;
+	};
+	std::vector<Entry> entries;
+
+	// rescan, other processes may have added or evicted entries
+	const auto now = std::filesystem::file_time_type::clock::now();
+	uint64_t total = 0;
+	std::error_code ec;
+	for (std::filesystem::recursive_directory_iterator itr(m_dir, ec), end; !ec && itr != end; itr.increment(ec))
+	{
+		// stats get their own error code, a file another process removed
+		// since the directory read is skipped instead of ending the scan
+		std::error_code stat_ec;
+		if (!itr->is_regular_file(stat_ec)) {
+			continue;
+		}
+		if (itr->path().extension() == ".tmp")
+		{
+			// left by a writer that died before its rename, younger ones
+			// may still be in flight and count towards the budget
+			const auto time = itr->last_write_time(stat_ec);
+			if (!stat_ec && now - time > STALE_TMP_AGE) {
+				std::filesystem::remove(itr->path(), stat_ec);
+			} else {
+				const uint64_t size = itr->file_size(stat_ec);
+				total += stat_ec ? 0 : size;
+			}
+			continue;
+		}
+		if (itr->path().extension() != ".bin") {
+			continue;
+		}
+		Entry e;
+		e.path = itr->path();
+		e.time = itr->last_write_time(stat_ec);
+		if (stat_ec) {
+			continue;
+		}
+		e.size = itr->file_size(stat_ec);
+		if (stat_ec) {
+			continue;
+		}
+		total += e.size;
+		entries.push_back(e);
+	}
+
+	// leave some headroom so that every store doesn't trigger a rescan
+	const uint64_t target = m_max_bytes / 4 * 3;
+	if (total > target)
+	{
+		std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+			return a.time < b.time;
+		});
+		for (auto& e : entries)
+		{
+			if (total <= target) {
+				break;
+			}
+			if (std::filesystem::remove(e.path, ec)) {
+				total -= e.size;
+			}
+		}
+	}
+
+	m_curr_bytes = total;
+}
+
+}
\ No newline at end of file
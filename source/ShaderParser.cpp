@@ -9,7 +9,7 @@
 namespace shadertrans
 {
 
-glslang::TShader* ShaderParser::ParseHLSL(const std::string& glsl)
+glslang::TShader* ShaderParser::ParseHLSL(std::string_view glsl, TargetEnv target_env)
 {
     GLSLangAdapter::Instance()->Init();
 
@@ -17,15 +17,17 @@ glslang::TShader* ShaderParser::ParseHLSL(const std::string& glsl)
 
     const EShLanguage shader_type = EShLanguage::EShLangFragment;
     glslang::TShader* shader = new glslang::TShader(shader_type);
-    const char* src_cstr = glsl.c_str();
-    shader->setStrings(&src_cstr, 1);
+    const char* src_cstr = glsl.data();
+    const int src_len = static_cast<int>(glsl.size());
+    shader->setStringsWithLengths(&src_cstr, &src_len, 1);
 
     //shader->setEnvTargetHlslFunctionality1();
     //shader->setHlslIoMapping(true);
     
     int client_input_semantics_version = 100; // maps to, say, #define VULKAN 100
-    glslang::EShTargetClientVersion VulkanClientVersion = glslang::EShTargetVulkan_1_0;
-    glslang::EShTargetLanguageVersion TargetVersion = glslang::EShTargetSpv_1_0;
+    glslang::EShTargetClientVersion VulkanClientVersion;
+    glslang::EShTargetLanguageVersion TargetVersion;
+    GLSLangAdapter::TargetEnv2GLSLang(target_env, VulkanClientVersion, TargetVersion);
 
 //    glslang::EProfile
 
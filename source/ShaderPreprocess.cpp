@@ -1,15 +1,19 @@
 #include "shadertrans/ShaderPreprocess.h"
-
-#include <sstream>
-#include <filesystem>
-#include <fstream>
+#include "shadertrans/IncludeResolver.h"
+#include "shadertrans/StringReplacer.h"
+#include "shadertrans/LineScanner.h"
 
 namespace shadertrans
 {
 
-std::string ShaderPreprocess::PrepareGLSL(ShaderStage stage, const std::string& source_code)
+std::string ShaderPreprocess::PrepareGLSL(ShaderStage stage, std::string_view source_code)
+{
+	return PrepareGLSL(stage, std::string(source_code));
+}
+
+std::string ShaderPreprocess::PrepareGLSL(ShaderStage stage, std::string&& source_code)
 {
-	std::string ret = source_code;
+	std::string ret = std::move(source_code);
 
 	if (ret.find("#version") == std::string::npos) {
 		if (stage == ShaderStage::ComputeShader) {
@@ -27,112 +31,97 @@ std::string ShaderPreprocess::PrepareGLSL(ShaderStage stage, const std::string&
 	return ret;
 }
 
-std::string ShaderPreprocess::PrepareHLSL(const std::string& source_code, const std::string& entry_point)
+std::string ShaderPreprocess::PrepareHLSL(std::string_view source_code, const std::string& entry_point)
 {
-	std::stringstream ss(source_code);
-
 	std::string out;
-	std::string line;
-	while (std::getline(ss, line))
+	out.reserve(source_code.size());
+
+	LineScanner scanner(source_code);
+	std::string_view line;
+	while (scanner.Next(line))
 	{
-		std::string path;
 		if (line == "struct type_Globals") {
 			out += "uniform __UBO__\n";
 		} else if (line == "uniform type_Globals _Globals;") {
 			;
 		} else if (line == "void main()") {
 			break;
-		} else if (line.find("layout(location = ") != std::string::npos) {
+		} else if (line.find("layout(location = ") != std::string_view::npos) {
 			;
 		} else {
-			out += line + '\n';
+			out.append(line.data(), line.size());
+			out += '\n';
 		}
 	}
 
-	StringReplace(out, " src_" + entry_point + "(", " " + entry_point + "(");
-	StringReplace(out, "_Globals.", "");
-
-	return out;
+	StringReplacer replacer({
+		{ " src_" + entry_point + "(", " " + entry_point + "(" },
+		{ "_Globals.", "" },
+	});
+	return replacer.Apply(out);
 }
 
-std::string ShaderPreprocess::RemoveIncludes(const std::string& source_code, std::vector<std::string>& include_paths)
+std::string ShaderPreprocess::RemoveIncludes(std::string_view source_code, std::vector<std::string>& include_paths)
 {
-	if (strncmp(source_code.c_str(), "#include", strlen("#include")) != 0) {
-		return source_code;
+	if (!LineScanner::StartsWith(source_code, "#include")) {
+		return std::string(source_code);
 	}
 
-	std::stringstream ss(source_code);
-
 	std::string out;
-	std::string line;
-	while (std::getline(ss, line)) 
+	out.reserve(source_code.size());
+
+	LineScanner scanner(source_code);
+	std::string_view line;
+	while (scanner.Next(line))
 	{
 		std::string path;
 		if (GetPathFromLine(line, path)) {
 			include_paths.push_back(path);
 		} else {
-			out += line + '\n';
+			out.append(line.data(), line.size());
+			out += '\n';
 		}
 	}
 
 	return out;
 }
 
-std::string ShaderPreprocess::ReplaceIncludes(const std::string& source_code)
+std::string ShaderPreprocess::ReplaceIncludes(std::string_view source_code,
+	                                          const std::vector<std::string>& search_paths)
 {
-	if (source_code.find("#include") == std::string::npos) {
-		return source_code;
+	if (source_code.find("#include") == std::string_view::npos) {
+		return std::string(source_code);
 	} else {
-		std::stringstream ss(source_code);
-		return LoadWithInclude(ss);
+		return IncludeResolver(search_paths).Resolve(source_code);
 	}
 }
 
-void ShaderPreprocess::StringReplace(std::string& str, const std::string& from, const std::string& to)
+std::string ShaderPreprocess::ReplaceIncludes(std::string_view source_code, const std::vector<std::string>& search_paths,
+	                                          std::vector<IncludeResolver::Dependency>& dependencies)
 {
-	if (from.empty()) {
-		return;
-	}
-	size_t start_pos = 0;
-	while ((start_pos = str.find(from, start_pos)) != std::string::npos) {
-		str.replace(start_pos, from.length(), to);
-		start_pos += to.length();
-	}
+	IncludeResolver resolver(search_paths);
+	auto ret = resolver.Resolve(source_code);
+	dependencies = resolver.GetDependencies();
+	return ret;
 }
 
-std::string ShaderPreprocess::LoadWithInclude(std::istream& cin)
+void ShaderPreprocess::StringReplace(std::string& str, const std::string& from, const std::string& to)
 {
-	std::string ret;
-	std::string line;
-	while (std::getline(cin, line))
-	{
-		std::string path;
-		if (GetPathFromLine(line, path))
-		{
-			// todo: include files search path
-			std::ifstream fin(path);
-			if (fin.is_open()) {
-				ret += LoadWithInclude(fin);
-			}
-		}
-		else
-		{
-			ret += line + '\n';
-		}
+	if (from.empty() || str.find(from) == std::string::npos) {
+		return;
 	}
-
-	return ret;
+	str = StringReplacer({ { from, to } }).Apply(str);
 }
 
-bool ShaderPreprocess::GetPathFromLine(const std::string& line, std::string& path)
+bool ShaderPreprocess::GetPathFromLine(std::string_view line, std::string& path)
 {
-	if (strncmp(line.c_str(), "#include", strlen("#include")) != 0) {
+	if (!LineScanner::StartsWith(line, "#include")) {
 		return false;
 	}
 
 	auto start = line.find_first_of('"');
 	auto end = line.find_last_of('"');
-	path = line.substr(start + 1, end - start - 1);
+	path = std::string(line.substr(start + 1, end - start - 1));
 
 	return true;
 }
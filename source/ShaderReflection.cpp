@@ -13,6 +13,7 @@
 #include <common/ConsoleLogger.h>
 
 #include <fstream>
+#include <algorithm>
 
 namespace
 {
@@ -112,34 +113,109 @@ VarType parse_spir_type(const spirv_cross::SPIRType& type)
 	return ret;
 }
 
+uint32_t basic_type_size(const spirv_cross::SPIRType& type, uint32_t matrix_stride, bool row_major)
+{
+    if (type.columns == 1) {
+        return type.vecsize * type.width / 8;
+    } else {
+        return matrix_stride * (row_major ? type.vecsize : type.columns);
+    }
+}
+
+void set_member_layout(const spirv_cross::CompilerGLSL& compiler,
+                       const spirv_cross::SPIRType& struct_type,
+                       uint32_t index, uint32_t base_offset, Variable& var)
+{
+    var.offset = base_offset + compiler.get_member_decoration(struct_type.self, index, ::spv::DecorationOffset);
+    var.size = static_cast<uint32_t>(compiler.get_declared_struct_member_size(struct_type, index));
+    var.array_stride = compiler.get_decoration(struct_type.member_types[index], ::spv::DecorationArrayStride);
+    var.matrix_stride = compiler.get_member_decoration(struct_type.self, index, ::spv::DecorationMatrixStride);
+}
+
+// An array of arrays gets an Array per dimension, outermost first, which
+// SPIRType::array keeps last. v_array has its name, offset and strides set.
+void get_array_elements(const spirv_cross::CompilerGLSL& compiler,
+                        spirv_cross::TypeID type_id,
+                        uint32_t elem_size,
+                        bool compact_arrays,
+                        Variable& v_array)
+{
+    auto& type = compiler.get_type(type_id);
+    v_array.array_size = type.array.back();
+    for (uint32_t i = 0, n = compact_arrays ? std::min(v_array.array_size, 1u) : v_array.array_size; i < n; ++i)
+    {
+        Variable elem;
+        elem.name = v_array.name + "[" + std::to_string(i) + "]";
+        elem.offset = v_array.offset + i * v_array.array_stride;
+        elem.matrix_stride = v_array.matrix_stride;
+        if (type.array.size() > 1)
+        {
+            elem.type = VarType::Array;
+            elem.array_stride = compiler.get_decoration(type.parent_type, ::spv::DecorationArrayStride);
+            elem.size = elem.array_stride * compiler.get_type(type.parent_type).array.back();
+            get_array_elements(compiler, type.parent_type, elem_size, compact_arrays, elem);
+        }
+        else
+        {
+            elem.type = parse_spir_type(type);
+            elem.size = elem_size;
+        }
+        v_array.children.push_back(elem);
+    }
+}
+
 void get_struct_uniforms(const spirv_cross::CompilerGLSL& compiler, 
                          spirv_cross::TypeID base_type_id,
                          const spirv_cross::SPIRType& type,
                          std::vector<Variable>& uniforms,
-                         const std::string& base_name)
+                         const std::string& base_name,
+                         uint32_t base_offset,
+                         bool compact_arrays)
 {   
     auto member_count = type.member_types.size();
     if (!type.array.empty()) 
     {
+        // outermost dimension, an array of arrays recurses with the element
+        // type, which keeps one dimension less
+        auto& elem_type = compiler.get_type(type.parent_type);
+        const uint32_t elem_size = elem_type.array.empty()
+            ? static_cast<uint32_t>(compiler.get_declared_struct_size(elem_type)) : 0;
+        const uint32_t length = type.array.back();
+
         Variable v_array;
         v_array.name = base_name;
         v_array.type = VarType::Array;
+        v_array.offset = base_offset;
+        v_array.array_stride = compiler.get_decoration(base_type_id, ::spv::DecorationArrayStride);
+        v_array.size = v_array.array_stride * length;
+        v_array.array_size = length;
 
-        for (int i = 0, n = type.array[0]; i < n; ++i)
+        for (uint32_t i = 0, n = compact_arrays ? std::min(length, 1u) : length; i < n; ++i)
         {
+            const std::string elem_name = base_name + "[" + std::to_string(i) + "]";
+            const uint32_t elem_offset = base_offset + i * v_array.array_stride;
+            if (!elem_type.array.empty()) {
+                get_struct_uniforms(compiler, type.parent_type, elem_type, v_array.children, elem_name, elem_offset, compact_arrays);
+                continue;
+            }
+
             Variable v_struct;
             v_struct.name = base_name;
             v_struct.type = VarType::Struct;
+            v_struct.offset = elem_offset;
+            v_struct.size = elem_size;
 
             for (int j = 0; j < member_count; j++)
             {
-                std::string full_name = base_name + "[" + std::to_string(i) + "]";
+                std::string full_name = elem_name;
                 auto name = compiler.get_member_name(type.parent_type, j);
                 full_name.append("." + name);
                 auto sub_type = compiler.get_type(type.member_types[j]);
+                const uint32_t member_offset = v_struct.offset 
+                    + compiler.get_member_decoration(type.parent_type, j, ::spv::DecorationOffset);
                 if (sub_type.basetype == spirv_cross::SPIRType::Struct)
                 {
-                    get_struct_uniforms(compiler, type.member_types[j], sub_type, v_struct.children, full_name);
+                    get_struct_uniforms(compiler, type.member_types[j], sub_type, v_struct.children, full_name, member_offset, compact_arrays);
                 }
                 else
                 {
@@ -148,8 +224,7 @@ void get_struct_uniforms(const spirv_cross::CompilerGLSL& compiler,
                     unif.name = full_name;
                     unif.type = parse_spir_type(sub_type);
 
-                    //size_t size = compiler.get_declared_struct_member_size(type, j);
-                    //size_t offset = compiler.type_struct_member_offset(type, j);
+                    set_member_layout(compiler, elem_type, j, v_struct.offset, unif);
 
                     v_struct.children.push_back(unif);
                 }
@@ -165,6 +240,8 @@ void get_struct_uniforms(const spirv_cross::CompilerGLSL& compiler,
         Variable v_struct;
         v_struct.name = base_name;
         v_struct.type = VarType::Struct;
+        v_struct.offset = base_offset;
+        v_struct.size = static_cast<uint32_t>(compiler.get_declared_struct_size(type));
 
         for (int i = 0; i < member_count; i++)
         {
@@ -175,25 +252,21 @@ void get_struct_uniforms(const spirv_cross::CompilerGLSL& compiler,
             auto sub_type = compiler.get_type(type.member_types[i]);
             if (sub_type.basetype == spirv_cross::SPIRType::Struct)
             {
-                get_struct_uniforms(compiler, type.member_types[i], sub_type, v_struct.children, name);
+                const uint32_t member_offset = base_offset 
+                    + compiler.get_member_decoration(base_type_id, i, ::spv::DecorationOffset);
+                get_struct_uniforms(compiler, type.member_types[i], sub_type, v_struct.children, name, member_offset, compact_arrays);
             }
             else if (!sub_type.array.empty())
             {
                 Variable v_array;
                 v_array.name = name;
                 v_array.type = VarType::Array;
+                set_member_layout(compiler, type, i, base_offset, v_array);
 
-                for (int i = 0, n = sub_type.array[0]; i < n; ++i)
-                {
-                    std::string full_name = name + "[" + std::to_string(i) + "]";
-
-                    Variable unif;
+                const bool row_major = compiler.has_member_decoration(base_type_id, i, ::spv::DecorationRowMajor);
+                const uint32_t elem_size = basic_type_size(sub_type, v_array.matrix_stride, row_major);
 
-                    unif.name = full_name;
-                    unif.type = parse_spir_type(sub_type);
-
-                    v_array.children.push_back(unif);
-                }
+                get_array_elements(compiler, type.member_types[i], elem_size, compact_arrays, v_array);
 
                 v_struct.children.push_back(v_array);
             }
@@ -204,6 +277,8 @@ void get_struct_uniforms(const spirv_cross::CompilerGLSL& compiler,
                 unif.name = name;
                 unif.type = parse_spir_type(sub_type);
 
+                set_member_layout(compiler, type, i, base_offset, unif);
+
                 v_struct.children.push_back(unif);
             }
         }
@@ -216,6 +291,25 @@ void get_struct_uniforms(const spirv_cross::CompilerGLSL& compiler,
     }
 }
 
+void set_binding(Variable& var, uint32_t binding)
+{
+    var.binding = binding;
+    for (auto& child : var.children) {
+        set_binding(child, binding);
+    }
+}
+
+void rebase_element(Variable& var, const std::string& from, const std::string& to, uint32_t delta)
+{
+    if (var.name.compare(0, from.size(), from) == 0) {
+        var.name.replace(0, from.size(), to);
+    }
+    var.offset += delta;
+    for (auto& child : var.children) {
+        rebase_element(child, from, to, delta);
+    }
+}
+
 Variable parser_spirv_variable(const shadertrans::spirv::Variable& var,
                                const shadertrans::spirv::Module& module)
 {
@@ -403,10 +497,10 @@ private:
 namespace shadertrans
 {
 
-void ShaderReflection::GetUniforms(const std::vector<unsigned int>& spirv, 
-	                               std::vector<Variable>& uniforms)
+void ShaderReflection::GetUniforms(SpirvSpan spirv, std::vector<Variable>& uniforms,
+                                   bool compact_arrays)
 {
-    spirv_cross::CompilerGLSL compiler(spirv);
+    spirv_cross::CompilerGLSL compiler(spirv.data(), spirv.size());
     spirv_cross::ShaderResources resources = compiler.get_shader_resources();
 
 	//// get_work_group_size_specialization_constants
@@ -438,6 +532,7 @@ void ShaderReflection::GetUniforms(const std::vector<unsigned int>& spirv,
         var.name = ssbo_name;
         var.type = VarType::StorageBuffer;
         var.binding = binding;
+        var.size = static_cast<uint32_t>(compiler.get_declared_struct_size(type));
 
         uniforms.push_back(var);
     }
@@ -447,12 +542,16 @@ void ShaderReflection::GetUniforms(const std::vector<unsigned int>& spirv,
     {
         auto ubo_name = compiler.get_name(resource.id);;
         spirv_cross::SPIRType type = compiler.get_type(resource.base_type_id);
+        const size_t first = uniforms.size();
         if (type.basetype == spirv_cross::SPIRType::Struct) {
-            get_struct_uniforms(compiler, resource.base_type_id, type, uniforms, ubo_name);
+            get_struct_uniforms(compiler, resource.base_type_id, type, uniforms, ubo_name, 0, compact_arrays);
         }
 
 		//uint32_t set = compiler.get_decoration(resource.id, ::spv::DecorationDescriptorSet);
-		//uint32_t binding = compiler.get_decoration(resource.id, ::spv::DecorationBinding);		
+		uint32_t binding = compiler.get_decoration(resource.id, ::spv::DecorationBinding);
+        for (size_t i = first; i < uniforms.size(); ++i) {
+            set_binding(uniforms[i], binding);
+        }
     }
 
     int idx = 0;
@@ -514,8 +613,7 @@ void ShaderReflection::GetUniforms(const std::vector<unsigned int>& spirv,
 	}
 }
 
-bool ShaderReflection::GetFunction(const std::vector<unsigned int>& spirv,
-                                   const std::string& name, Function& func)
+bool ShaderReflection::GetFunction(SpirvSpan spirv, std::string_view name, Function& func)
 {
     spvgentwo::HeapAllocator alloc;
     spvgentwo::ConsoleLogger logger;
@@ -585,4 +683,27 @@ bool ShaderReflection::GetFunction(const std::vector<unsigned int>& spirv,
     ////////////////////////////////////////////////////////////////////////////
 }
 
+void ShaderReflection::ExpandArray(const Variable& array, std::vector<Variable>& elements)
+{
+    if (array.type != VarType::Array || array.children.empty()) {
+        return;
+    }
+
+    // children[0] is the template, every other element only differs in
+    // the index in its names and in the offsets
+    auto& first = array.children.front();
+    const std::string from = array.name + "[0]";
+    for (uint32_t i = 0; i < array.array_size; ++i)
+    {
+        if (i < array.children.size()) {
+            elements.push_back(array.children[i]);
+            continue;
+        }
+
+        Variable elem = first;
+        rebase_element(elem, from, array.name + "[" + std::to_string(i) + "]", i * array.array_stride);
+        elements.push_back(elem);
+    }
+}
+
 }
\ No newline at end of file
@@ -2,151 +2,342 @@
 #include "shadertrans/ConfigGLSL.h"
 #include "shadertrans/CompilerDX.h"
 #include "shadertrans/GLSLangAdapter.h"
+#include "shadertrans/ShaderCache.h"
+#include "shadertrans/ShaderDiskCache.h"
+#include "shadertrans/Hasher.h"
+#include "shadertrans/SpirvTools.h"
 
 #include <glslang/public/ShaderLang.h>
-#include <StandAlone/DirStackFileIncluder.h>
 #include <SPIRV/GlslangToSpv.h>
 #include <spirv.hpp>
 #include <spirv_glsl.hpp>
+#include <spirv_cross_c.h>
+#include <spirv-tools/libspirv.h>
 #include <dxc/Support/WinIncludes.h>
 #include <dxc/dxcapi.h>
 
 #include <iostream>
+#include <sstream>
+#include <fstream>
+#include <iterator>
 #include <atomic>
+#include <thread>
+#include <algorithm>
+#include <mutex>
+#include <filesystem>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <string_view>
+
+#ifndef SHADERTRANS_SPIRV_CROSS_REVISION
+#define SHADERTRANS_SPIRV_CROSS_REVISION ""
+#endif
+
+namespace
+{
+
+// the headers a source reaches, wherever they resolved from; the hashes come
+// from IncludeCache, which only rereads a header once its size or mtime changes
+void hash_dependencies(shadertrans::Hasher& hasher, const std::vector<shadertrans::IncludeResolver::Dependency>& deps)
+{
+    hasher.Update(static_cast<uint64_t>(deps.size()));
+    for (auto& dep : deps) {
+        hasher.Update(dep.path).Update(dep.hash);
+    }
+}
+
+// toolchain versions go into every key, so that upgrading a compiler
+// invalidates the entries it produced
 
-namespace hlsl
+uint64_t glslang_version()
 {
+    static const uint64_t version = shadertrans::Hasher()
+        .Update(glslang::GetGlslVersionString())
+        .Update(static_cast<uint32_t>(glslang::GetSpirvGeneratorVersion()))
+        .Digest();
+    return version;
+}
 
-class Blob
+uint64_t dxc_version()
 {
-public:
-    Blob(const void* data, uint32_t size)
-        : data_(reinterpret_cast<const uint8_t*>(data), reinterpret_cast<const uint8_t*>(data) + size)
+    static const uint64_t version = []() {
+        shadertrans::Hasher hasher;
+
+        auto dx = shadertrans::CompilerDX::Instance().Acquire();
+        auto compiler = dx.Compiler();
+
+        CComPtr<IDxcVersionInfo> info;
+        if (SUCCEEDED(compiler->QueryInterface(__uuidof(IDxcVersionInfo), reinterpret_cast<void**>(&info))))
+        {
+            UINT32 major = 0, minor = 0;
+            info->GetVersion(&major, &minor);
+            hasher.Update(static_cast<uint32_t>(major)).Update(static_cast<uint32_t>(minor));
+        }
+
+        CComPtr<IDxcVersionInfo2> info2;
+        if (SUCCEEDED(compiler->QueryInterface(__uuidof(IDxcVersionInfo2), reinterpret_cast<void**>(&info2))))
+        {
+            UINT32 commit_count = 0;
+            char* commit_hash = nullptr;
+            if (SUCCEEDED(info2->GetCommitInfo(&commit_count, &commit_hash)))
+            {
+                hasher.Update(static_cast<uint32_t>(commit_count)).Update(commit_hash);
+                CoTaskMemFree(commit_hash);
+            }
+        }
+
+        return hasher.Digest();
+    }();
+    return version;
+}
+
+// the C API version stays put across most revisions that change the
+// generated GLSL, the build passes in the git revision too
+uint64_t spvcross_version()
+{
+    return shadertrans::Hasher()
+        .Update(static_cast<uint32_t>(SPVC_C_API_VERSION_MAJOR))
+        .Update(static_cast<uint32_t>(SPVC_C_API_VERSION_MINOR))
+        .Update(static_cast<uint32_t>(SPVC_C_API_VERSION_PATCH))
+        .Update(SHADERTRANS_SPIRV_CROSS_REVISION)
+        .Digest();
+}
+
+// the details string carries the revision spvtools was built from, which
+// changes with optimizer passes between releases
+uint64_t spvtools_version()
+{
+    static const uint64_t version = shadertrans::Hasher()
+        .Update(spvSoftwareVersionDetailsString())
+        .Digest();
+    return version;
+}
+
+void hash_optimize(shadertrans::Hasher& hasher, const shadertrans::SpirvTools::OptimizeOptions& options)
+{
+    hasher.Update(static_cast<uint32_t>(options.preset));
+    if (options.preset != shadertrans::SpirvTools::Optimization::None) {
+        hasher.Update(spvtools_version());
+    }
+    if (options.preset == shadertrans::SpirvTools::Optimization::Custom)
     {
+        hasher.Update(static_cast<uint64_t>(options.passes.size()));
+        for (auto& pass : options.passes) {
+            hasher.Update(pass);
+        }
     }
+}
 
-    const void* Data() const
-    {
-        return data_.data();
+bool use_cache()
+{
+    return shadertrans::ShaderCache::Instance().IsEnable()
+        || shadertrans::ShaderDiskCache::Instance().IsEnable();
+}
+
+bool cache_load(uint64_t key, std::vector<unsigned int>& spirv)
+{
+    auto& mem = shadertrans::ShaderCache::Instance();
+    if (mem.IsEnable() && mem.Query(key, spirv)) {
+        return true;
     }
 
-    uint32_t Size() const
+    auto& disk = shadertrans::ShaderDiskCache::Instance();
+    if (disk.IsEnable() && disk.Load(key, spirv))
     {
-        return static_cast<uint32_t>(data_.size());
+        if (mem.IsEnable()) {
+            mem.Insert(key, spirv);
+        }
+        return true;
     }
 
-private:
-    std::vector<uint8_t> data_;
-};
-
-Blob* CreateBlob(const void* data, uint32_t size)
-{
-    return new Blob(data, size);
+    return false;
 }
 
-void DestroyBlob(Blob* blob)
+void cache_store(uint64_t key, const std::vector<unsigned int>& spirv)
 {
-    delete blob;
+    if (spirv.empty()) {
+        return;
+    }
+
+    auto& mem = shadertrans::ShaderCache::Instance();
+    if (mem.IsEnable()) {
+        mem.Insert(key, spirv);
+    }
+
+    auto& disk = shadertrans::ShaderDiskCache::Instance();
+    if (disk.IsEnable()) {
+        disk.Store(key, spirv);
+    }
 }
 
-class ScIncludeHandler : public IDxcIncludeHandler
+// runs func(0..count-1) on thread_num workers, the caller thread included
+void parallel_for(size_t count, int thread_num, const std::function<void(size_t)>& func)
 {
-public:
-    explicit ScIncludeHandler(std::function<Blob*(const char* includeName)> loadCallback) : m_loadCallback(std::move(loadCallback))
-    {
+    if (count == 0) {
+        return;
     }
 
-    HRESULT STDMETHODCALLTYPE LoadSource(LPCWSTR fileName, IDxcBlob** includeSource) override
+    if (thread_num <= 0) {
+        thread_num = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+    thread_num = static_cast<int>(std::min(static_cast<size_t>(thread_num), count));
+
+    std::atomic<size_t> next = 0;
+    auto worker = [&]()
     {
-        if ((fileName[0] == L'.') && (fileName[1] == L'/'))
-        {
-            fileName += 2;
+        for (size_t i = next++; i < count; i = next++) {
+            func(i);
         }
+    };
 
-        std::string utf8FileName;
-        if (!Unicode::WideToUTF8String(fileName, &utf8FileName))
-        {
-            return E_FAIL;
-        }
+    std::vector<std::thread> threads;
+    for (int i = 1; i < thread_num; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& t : threads) {
+        t.join();
+    }
+}
 
-        auto blobDeleter = [](Blob* blob) { DestroyBlob(blob); };
+// over-approximates, includes under a false #if are listed too
+void collect_dependencies(std::string_view source, const char* inc_dir,
+                          std::vector<shadertrans::IncludeResolver::Dependency>& deps)
+{
+    deps.clear();
+    if (source.find("#include") == std::string_view::npos) {
+        return;
+    }
 
-        std::unique_ptr<Blob, decltype(blobDeleter)> source(nullptr, blobDeleter);
-        try
-        {
-            source.reset(m_loadCallback(utf8FileName.c_str()));
-        }
-        catch (...)
-        {
-            return E_FAIL;
-        }
+    std::vector<std::string> search_paths;
+    if (inc_dir) {
+        search_paths.push_back(inc_dir);
+    }
+    shadertrans::IncludeResolver resolver(search_paths);
+    resolver.Resolve(source);
+    deps = resolver.GetDependencies();
+}
 
-        *includeSource = nullptr;
-        return shadertrans::CompilerDX::Instance().Library()->CreateBlobWithEncodingOnHeapCopy(
-            source->Data(), source->Size(), CP_UTF8, reinterpret_cast<IDxcBlobEncoding**>(includeSource)
-        );
+// Looks includes up with IncludeResolver::Find: "path" next to the including
+// file, then inc_dir, then the working directory; <path> skips the first.
+// Records each file it hands to glslang, so the list only holds the headers
+// the compile actually reached.
+class ResolverIncluder : public glslang::TShader::Includer
+{
+public:
+    ResolverIncluder(const char* inc_dir)
+        : m_resolver(inc_dir ? std::vector<std::string>{ inc_dir } : std::vector<std::string>())
+    {
     }
 
-    ULONG STDMETHODCALLTYPE AddRef() override
+    IncludeResult* includeSystem(const char* header_name, const char* includer_name, size_t inclusion_depth) override
     {
-        ++m_ref;
-        return m_ref;
+        return Include(header_name, includer_name, true);
     }
 
-    ULONG STDMETHODCALLTYPE Release() override
+    IncludeResult* includeLocal(const char* header_name, const char* includer_name, size_t inclusion_depth) override
     {
-        --m_ref;
-        ULONG result = m_ref;
-        if (result == 0)
+        return Include(header_name, includer_name, false);
+    }
+
+    void releaseInclude(IncludeResult* result) override
+    {
+        if (result)
         {
-            delete this;
+            delete static_cast<std::string*>(result->userData);
+            delete result;
         }
-        return result;
     }
 
-    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, void** object) override
+    std::vector<shadertrans::IncludeResolver::Dependency>& GetDependencies() { return m_deps; }
+
+private:
+    IncludeResult* Include(const char* header_name, const char* includer_name, bool system)
     {
-        if (IsEqualIID(iid, __uuidof(IDxcIncludeHandler)))
-        {
-            *object = dynamic_cast<IDxcIncludeHandler*>(this);
-            this->AddRef();
-            return S_OK;
+        shadertrans::IncludeCache::Include include;
+        include.path   = header_name;
+        include.system = system;
+
+        std::string from_dir;
+        if (includer_name && includer_name[0]) {
+            from_dir = std::filesystem::path(includer_name).parent_path().generic_string();
         }
-        else if (IsEqualIID(iid, __uuidof(IUnknown)))
-        {
-            *object = dynamic_cast<IUnknown*>(this);
-            this->AddRef();
-            return S_OK;
+
+        auto path = m_resolver.Find(include, from_dir);
+        if (path.empty()) {
+            return nullptr;
         }
-        else
-        {
-            return E_NOINTERFACE;
+
+        std::ifstream fin(path, std::ios::binary);
+        if (!fin.is_open()) {
+            return nullptr;
         }
+        auto text = new std::string((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+
+        if (m_dep_paths.insert(path).second) {
+            m_deps.push_back({ path, shadertrans::Hasher().Update(*text).Digest() });
+        }
+
+        // glslang reports nested includes against this name
+        return new IncludeResult(path, text->data(), text->size(), text);
     }
 
 private:
-    std::function<Blob*(const char* includeName)> m_loadCallback;
+    shadertrans::IncludeResolver m_resolver;
+
+    std::vector<shadertrans::IncludeResolver::Dependency> m_deps;
+    std::unordered_set<std::string> m_dep_paths;
 
-    std::atomic<ULONG> m_ref = 0;
-};
+}; // ResolverIncluder
 
-Blob* DefaultLoadCallback(const char* includeName)
+void merge_dependencies(std::vector<shadertrans::IncludeResolver::Dependency>& dst,
+                        const std::vector<shadertrans::IncludeResolver::Dependency>& src)
 {
-    std::vector<char> ret;
-    std::ifstream includeFile(includeName, std::ios_base::in);
-    if (includeFile)
+    for (auto& dep : src)
     {
-        includeFile.seekg(0, std::ios::end);
-        ret.resize(static_cast<size_t>(includeFile.tellg()));
-        includeFile.seekg(0, std::ios::beg);
-        includeFile.read(ret.data(), ret.size());
-        ret.resize(static_cast<size_t>(includeFile.gcount()));
+        auto itr = std::find_if(dst.begin(), dst.end(), [&](const shadertrans::IncludeResolver::Dependency& d) {
+            return d.path == dep.path;
+        });
+        if (itr == dst.end()) {
+            dst.push_back(dep);
+        }
     }
-    else
+}
+
+bool preprocess_glsl(shadertrans::ShaderStage stage, std::string_view glsl, const std::string& preamble,
+                     const char* inc_dir, shadertrans::TargetEnv target_env, std::string& preprocessed,
+                     std::vector<shadertrans::IncludeResolver::Dependency>& deps, std::ostream& out)
+{
+    glslang::EShTargetClientVersion VulkanClientVersion;
+    glslang::EShTargetLanguageVersion TargetVersion;
+    shadertrans::GLSLangAdapter::TargetEnv2GLSLang(target_env, VulkanClientVersion, TargetVersion);
+
+    const EShLanguage shader_type = shadertrans::GLSLangAdapter::Type2GLSLang(stage);
+    glslang::TShader shader(shader_type);
+    const char* src_cstr = glsl.data();
+    const int src_len = static_cast<int>(glsl.size());
+    shader.setStringsWithLengths(&src_cstr, &src_len, 1);
+    shader.setPreamble(preamble.c_str());
+
+    shader.setEnvInput(glslang::EShSourceGlsl, shader_type, glslang::EShClientVulkan, 100);
+    shader.setEnvClient(glslang::EShClientVulkan, VulkanClientVersion);
+    shader.setEnvTarget(glslang::EShTargetSpv, TargetVersion);
+
+    TBuiltInResource resources;
+    resources = glsl::DefaultTBuiltInResource;
+    EShMessages messages = (EShMessages)(EShMsgSpvRules | EShMsgVulkanRules);
+
+    ResolverIncluder includer(inc_dir);
+    const bool succ = shader.preprocess(&resources, 100, ENoProfile, false, false, messages, &preprocessed, includer);
+    deps = std::move(includer.GetDependencies());
+    if (!succ)
     {
-        throw std::runtime_error(std::string("COULDN'T load included file ") + includeName + ".");
+        out << "GLSL Preprocessing Failed for: " << preamble << "\n";
+        out << shader.getInfoLog() << "\n" << shader.getInfoDebugLog() << "\n";
+        return false;
     }
-    return CreateBlob(ret.data(), static_cast<uint32_t>(ret.size()));
+    return true;
 }
 
 }
@@ -154,31 +345,77 @@ Blob* DefaultLoadCallback(const char* includeName)
 namespace shadertrans
 {
 
-void ShaderTrans::HLSL2SpirV(ShaderStage stage, const std::string& hlsl, const std::string& entry_point,
+bool ShaderTrans::IsHLSLAvailable()
+{
+    return CompilerDX::Instance().IsAvailable();
+}
+
+void ShaderTrans::HLSL2SpirV(ShaderStage stage, std::string_view hlsl, const std::string& entry_point,
                              std::vector<unsigned int>& spirv, std::ostream& out)
 {
-    std::vector<const wchar_t*> dxcArgs;
-    dxcArgs.push_back(L"-Zpr");
-    dxcArgs.push_back(L"-O0");
-    dxcArgs.push_back(L"-spirv");
+    HLSL2SpirV(stage, hlsl, entry_point, HLSLOptions(), spirv, out);
+}
+
+void ShaderTrans::HLSL2SpirV(ShaderStage stage, std::string_view hlsl, const std::string& entry_point,
+                             const HLSLOptions& options, std::vector<unsigned int>& spirv, std::ostream& out)
+{
+    // no failure below may hand back what the caller had in spirv
+    spirv.clear();
+
+    if (!IsHLSLAvailable())
+    {
+        out << CompilerDX::Instance().GetLoadError() << "\n";
+        return;
+    }
+
+    DxcArguments dxcArgs(options);
+
+    std::wstring shaderProfile = hlsl_shader_profile_name(stage, 6, 0);;
+
+    // includes are resolved by the dxc callback and can't be seen by the key
+    uint64_t cache_key = 0;
+    const bool cached = use_cache() && hlsl.find("#include") == std::string_view::npos;
+    if (cached)
+    {
+        Hasher hasher;
+        hasher.Update("hlsl2spirv")
+              .Update(static_cast<uint32_t>(stage))
+              .Update(hlsl)
+              .Update(entry_point)
+              .Update(dxc_version());
+        for (auto& arg : dxcArgs.Args()) {
+            hasher.Update(arg, wcslen(arg) * sizeof(wchar_t));
+        }
+        for (auto& define : options.defines) {
+            hasher.Update(define.first).Update(define.second);
+        }
+        hasher.Update(shaderProfile.data(), shaderProfile.size() * sizeof(wchar_t));
+        hash_optimize(hasher, options.optimize);
+        cache_key = hasher.Digest();
+
+        if (cache_load(cache_key, spirv)) {
+            return;
+        }
+    }
+
+    auto dx = shadertrans::CompilerDX::Instance().Acquire();
 
     CComPtr<IDxcBlobEncoding> sourceBlob;
-    IFT(shadertrans::CompilerDX::Instance().Library()->CreateBlobWithEncodingOnHeapCopy(hlsl.c_str(), hlsl.size(),
+    IFT(dx.Library()->CreateBlobWithEncodingOnHeapCopy(hlsl.data(), static_cast<UINT32>(hlsl.size()),
         CP_UTF8, &sourceBlob));
     IFTARG(sourceBlob->GetBufferSize() >= 4);
 
     std::wstring entryPointUtf16;
     Unicode::UTF8ToWideString(entry_point.c_str(), &entryPointUtf16);
 
-    std::wstring shaderProfile = hlsl_shader_profile_name(stage, 6, 0);;
-
-    std::vector<DxcDefine> dxcDefines;
+    auto& args = dxcArgs.Args();
+    auto& defines = dxcArgs.Defines();
 
-    CComPtr<IDxcIncludeHandler> includeHandler = new hlsl::ScIncludeHandler(std::move(hlsl::DefaultLoadCallback));
+    CComPtr<IDxcIncludeHandler> includeHandler = new ScIncludeHandler(dx.Library(), DefaultLoadCallback);
     CComPtr<IDxcOperationResult> compileResult;
-    IFT(shadertrans::CompilerDX::Instance().Compiler()->Compile(sourceBlob, nullptr, entryPointUtf16.c_str(), shaderProfile.c_str(),
-        dxcArgs.data(), static_cast<UINT32>(dxcArgs.size()), dxcDefines.data(),
-        static_cast<UINT32>(dxcDefines.size()), includeHandler, &compileResult));
+    IFT(dx.Compiler()->Compile(sourceBlob, nullptr, entryPointUtf16.c_str(), shaderProfile.c_str(),
+        const_cast<LPCWSTR*>(args.data()), static_cast<UINT32>(args.size()), defines.data(),
+        static_cast<UINT32>(defines.size()), includeHandler, &compileResult));
 
     CComPtr<IDxcBlobEncoding> errors;
     IFT(compileResult->GetErrorBuffer(&errors));
@@ -186,7 +423,6 @@ void ShaderTrans::HLSL2SpirV(ShaderStage stage, const std::string& hlsl, const s
     {
         if (errors->GetBufferSize() > 0)
         {
-            spirv.clear();
             out << static_cast<const char*>(errors->GetBufferPointer()) << "\n";
             return;
         }
@@ -207,27 +443,98 @@ void ShaderTrans::HLSL2SpirV(ShaderStage stage, const std::string& hlsl, const s
             spirv.assign(data, reinterpret_cast<const unsigned int*>(data) + size);
         }
     }
+    if (spirv.empty())
+    {
+        out << "HLSL compile produced no spirv\n";
+        return;
+    }
+
+    if (!SpirvTools::Optimize(spirv, options.optimize, options.target_env, out)) {
+        spirv.clear();
+        return;
+    }
+
+    if (cached) {
+        cache_store(cache_key, spirv);
+    }
 }
 
-void ShaderTrans::GLSL2SpirV(ShaderStage stage, const std::string& glsl, const char* inc_dir,
+void ShaderTrans::GLSL2SpirV(ShaderStage stage, std::string_view glsl, const char* inc_dir,
 	                         std::vector<unsigned int>& spirv, bool no_link, std::ostream& out)
 {
+    GLSLOptions options;
+    options.no_link = no_link;
+    GLSL2SpirV(stage, glsl, inc_dir, options, spirv, out);
+}
+
+void ShaderTrans::GLSL2SpirV(ShaderStage stage, std::string_view glsl, const char* inc_dir,
+	                         const GLSLOptions& options, std::vector<unsigned int>& spirv, std::ostream& out)
+{
+    CompileGLSL(stage, glsl, inc_dir, options, spirv, nullptr, out);
+}
+
+void ShaderTrans::GLSL2SpirV(ShaderStage stage, std::string_view glsl, const char* inc_dir,
+                             const GLSLOptions& options, std::vector<unsigned int>& spirv,
+                             std::vector<IncludeResolver::Dependency>& dependencies, std::ostream& out)
+{
+    CompileGLSL(stage, glsl, inc_dir, options, spirv, &dependencies, out);
+}
+
+void ShaderTrans::CompileGLSL(ShaderStage stage, std::string_view glsl, const char* inc_dir,
+                              const GLSLOptions& options, std::vector<unsigned int>& spirv,
+                              std::vector<IncludeResolver::Dependency>* dependencies, std::ostream& out)
+{
+    const bool no_link = options.no_link;
+    spirv.clear();
+    if (dependencies) {
+        dependencies->clear();
+    }
     if (glsl.empty()) {
         return;
     }
 
-    GLSLangAdapter::Instance()->Init();
+    int client_input_semantics_version = 100; // maps to, say, #define VULKAN 100
+    glslang::EShTargetClientVersion VulkanClientVersion;
+    glslang::EShTargetLanguageVersion TargetVersion;
+    GLSLangAdapter::TargetEnv2GLSLang(options.target_env, VulkanClientVersion, TargetVersion);
+
+    uint64_t cache_key = 0;
+    std::vector<IncludeResolver::Dependency> cache_deps;
+    const bool cached = use_cache();
+    if (cached)
+    {
+        collect_dependencies(glsl, inc_dir, cache_deps);
+
+        Hasher hasher;
+        hasher.Update("glsl2spirv")
+              .Update(static_cast<uint32_t>(stage))
+              .Update(glsl)
+              .Update(no_link)
+              .Update(static_cast<uint32_t>(client_input_semantics_version))
+              .Update(static_cast<uint32_t>(VulkanClientVersion))
+              .Update(static_cast<uint32_t>(TargetVersion))
+              .Update(glslang_version());
+        hasher.Update(inc_dir);
+        hash_dependencies(hasher, cache_deps);
+        hash_optimize(hasher, options.optimize);
+        cache_key = hasher.Digest();
+
+        if (cache_load(cache_key, spirv))
+        {
+            if (dependencies) {
+                *dependencies = std::move(cache_deps);
+            }
+            return;
+        }
+    }
 
-    spirv.clear();
+    GLSLangAdapter::Instance()->Init();
 
     const EShLanguage shader_type = GLSLangAdapter::Type2GLSLang(stage);
     glslang::TShader shader(shader_type);
-    const char* src_cstr = glsl.c_str();
-    shader.setStrings(&src_cstr, 1);
-
-    int client_input_semantics_version = 100; // maps to, say, #define VULKAN 100
-    glslang::EShTargetClientVersion VulkanClientVersion = glslang::EShTargetVulkan_1_0;
-    glslang::EShTargetLanguageVersion TargetVersion = glslang::EShTargetSpv_1_0;
+    const char* src_cstr = glsl.data();
+    const int src_len = static_cast<int>(glsl.size());
+    shader.setStringsWithLengths(&src_cstr, &src_len, 1);
 
     shader.setEnvInput(glslang::EShSourceGlsl, shader_type, glslang::EShClientVulkan, client_input_semantics_version);
     shader.setEnvClient(glslang::EShClientVulkan, VulkanClientVersion);
@@ -242,13 +549,13 @@ void ShaderTrans::GLSL2SpirV(ShaderStage stage, const std::string& glsl, const c
 
     const int default_version = 100;
 
-    DirStackFileIncluder includer;
-    if (inc_dir) {
-        includer.pushExternalLocalDirectory(inc_dir);
-    }
-
+    ResolverIncluder includer(inc_dir);
     std::string preprocessed_glsl;
-    if (!shader.preprocess(&resources, default_version, ENoProfile, false, false, messages, &preprocessed_glsl, includer))
+    const bool preprocessed = shader.preprocess(&resources, default_version, ENoProfile, false, false, messages, &preprocessed_glsl, includer);
+    if (dependencies) {
+        *dependencies = std::move(includer.GetDependencies());
+    }
+    if (!preprocessed)
     {
         out << "GLSL Preprocessing Failed for: " << glsl << "\n";
         out << shader.getInfoLog() << "\n" << shader.getInfoDebugLog() << "\n";
@@ -299,13 +606,40 @@ void ShaderTrans::GLSL2SpirV(ShaderStage stage, const std::string& glsl, const c
         glslang::SpvOptions spv_options;
         glslang::GlslangToSpv(*program.getIntermediate(shader_type), spirv, &logger, &spv_options);
     }
+
+    if (!SpirvTools::Optimize(spirv, options.optimize, options.target_env, out)) {
+        spirv.clear();
+        return;
+    }
+
+    if (cached) {
+        cache_store(cache_key, spirv);
+    }
 }
 
-void ShaderTrans::SpirV2GLSL(ShaderStage stage, const std::vector<unsigned int>& spirv,
+void ShaderTrans::SpirV2GLSL(ShaderStage stage, SpirvSpan spirv,
                              std::string& glsl, bool use_ubo, std::ostream& out)
 {
+    auto& disk = ShaderDiskCache::Instance();
+
+    uint64_t cache_key = 0;
+    const bool cached = disk.IsEnable();
+    if (cached)
+    {
+        cache_key = Hasher()
+            .Update("spirv2glsl")
+            .Update(static_cast<uint32_t>(stage))
+            .Update(spirv.data(), spirv.size() * sizeof(unsigned int))
+            .Update(use_ubo)
+            .Update(spvcross_version())
+            .Digest();
+        if (disk.Load(cache_key, glsl)) {
+            return;
+        }
+    }
+
     try {
-        spirv_cross::CompilerGLSL compiler(spirv);
+        spirv_cross::CompilerGLSL compiler(spirv.data(), spirv.size());
 
         auto op = compiler.get_common_options();
         if (!use_ubo) {
@@ -351,6 +685,10 @@ void ShaderTrans::SpirV2GLSL(ShaderStage stage, const std::vector<unsigned int>&
             }
 
             glsl = compiler.compile();
+
+            if (cached) {
+                disk.Store(cache_key, glsl);
+            }
         } catch (const std::exception& e) {
             out << e.what() << "\n";
             return;
@@ -362,4 +700,170 @@ void ShaderTrans::SpirV2GLSL(ShaderStage stage, const std::vector<unsigned int>&
     }
 }
 
+std::vector<unsigned int> ShaderTrans::HLSL2SpirV(ShaderStage stage, std::string_view hlsl, const std::string& entry_point,
+                                                  const HLSLOptions& options, std::ostream& out)
+{
+    std::vector<unsigned int> spirv;
+    HLSL2SpirV(stage, hlsl, entry_point, options, spirv, out);
+    return spirv;
+}
+
+std::vector<unsigned int> ShaderTrans::GLSL2SpirV(ShaderStage stage, std::string_view glsl, const char* inc_dir,
+                                                  const GLSLOptions& options, std::ostream& out)
+{
+    std::vector<unsigned int> spirv;
+    GLSL2SpirV(stage, glsl, inc_dir, options, spirv, out);
+    return spirv;
+}
+
+std::string ShaderTrans::SpirV2GLSL(ShaderStage stage, SpirvSpan spirv, bool use_ubo, std::ostream& out)
+{
+    std::string glsl;
+    SpirV2GLSL(stage, spirv, glsl, use_ubo, out);
+    return glsl;
+}
+
+void ShaderTrans::BatchToSpirV(const std::vector<BatchJob>& jobs,
+                               std::vector<BatchResult>& results, int thread_num)
+{
+    results.clear();
+    results.resize(jobs.size());
+    if (jobs.empty()) {
+        return;
+    }
+
+    // process init before any worker touches glslang
+    GLSLangAdapter::Instance()->Init();
+
+    parallel_for(jobs.size(), thread_num, [&](size_t i)
+    {
+        auto& job = jobs[i];
+        auto& ret = results[i];
+
+        const char* inc_dir = job.inc_dir.empty() ? nullptr : job.inc_dir.c_str();
+
+        std::ostringstream out;
+        try {
+            switch (job.lang)
+            {
+            case Language::GLSL:
+            {
+                GLSLOptions options;
+                options.no_link    = job.no_link;
+                options.target_env = job.target_env;
+                options.optimize   = job.optimize;
+                GLSL2SpirV(job.stage, job.source, inc_dir, options, ret.spirv, ret.dependencies, out);
+                break;
+            }
+            case Language::HLSL:
+            {
+                HLSLOptions options;
+                options.target_env = job.target_env;
+                options.optimize   = job.optimize;
+                if (inc_dir) {
+                    options.include_dirs.push_back(job.inc_dir);
+                }
+                collect_dependencies(job.source, inc_dir, ret.dependencies);
+                HLSL2SpirV(job.stage, job.source, job.entry_point, options, ret.spirv, out);
+                break;
+            }
+            }
+        } catch (const std::exception& e) {
+            ret.spirv.clear();
+            ret.dependencies.clear();
+            out << e.what() << "\n";
+        } catch (...) {
+            ret.spirv.clear();
+            ret.dependencies.clear();
+            out << "unknown compile error\n";
+        }
+        ret.log = out.str();
+    });
+}
+
+void ShaderTrans::PermutationToSpirV(ShaderStage stage, std::string_view glsl, const char* inc_dir,
+                                     const GLSLOptions& options, const std::vector<DefineSet>& variants,
+                                     PermutationResult& result, int thread_num)
+{
+    result.variants.clear();
+    result.outputs.clear();
+    result.dependencies.clear();
+    if (variants.empty()) {
+        return;
+    }
+
+    GLSLangAdapter::Instance()->Init();
+
+    // defines and includes are resolved here, the compile pass below only
+    // sees self-contained texts
+    std::vector<std::string> texts(variants.size());
+    std::vector<std::string> logs(variants.size());
+    std::vector<std::vector<IncludeResolver::Dependency>> deps(variants.size());
+    parallel_for(variants.size(), thread_num, [&](size_t i)
+    {
+        std::string preamble;
+        for (auto& define : variants[i])
+        {
+            preamble += "#define " + define.first;
+            if (!define.second.empty()) {
+                preamble += " " + define.second;
+            }
+            preamble += "\n";
+        }
+
+        std::ostringstream out;
+        if (!preprocess_glsl(stage, glsl, preamble, inc_dir, options.target_env, texts[i], deps[i], out)) {
+            texts[i].clear();
+        }
+        logs[i] = out.str();
+    });
+    for (auto& d : deps) {
+        merge_dependencies(result.dependencies, d);
+    }
+
+    std::vector<BatchJob> jobs;
+    std::vector<size_t> job_outputs;
+    std::unordered_map<std::string_view, size_t> text2output;
+
+    result.variants.resize(variants.size());
+    for (size_t i = 0; i < variants.size(); ++i)
+    {
+        if (texts[i].empty())
+        {
+            // failures keep their own log
+            result.variants[i] = result.outputs.size();
+            result.outputs.emplace_back();
+            result.outputs.back().log = std::move(logs[i]);
+            continue;
+        }
+
+        auto itr = text2output.find(texts[i]);
+        if (itr != text2output.end()) {
+            result.variants[i] = itr->second;
+            continue;
+        }
+
+        const size_t idx = result.outputs.size();
+        result.outputs.emplace_back();
+        text2output.insert({ texts[i], idx });
+        result.variants[i] = idx;
+
+        BatchJob job;
+        job.stage      = stage;
+        job.lang       = Language::GLSL;
+        job.source     = texts[i];
+        job.no_link    = options.no_link;
+        job.target_env = options.target_env;
+        job.optimize   = options.optimize;
+        jobs.push_back(std::move(job));
+        job_outputs.push_back(idx);
+    }
+
+    std::vector<BatchResult> compiled;
+    BatchToSpirV(jobs, compiled, thread_num);
+    for (size_t i = 0; i < compiled.size(); ++i) {
+        result.outputs[job_outputs[i]] = std::move(compiled[i]);
+    }
+}
+
 }
\ No newline at end of file
@@ -23,26 +23,43 @@ namespace shadertrans
 ShaderValidator::ShaderValidator(ShaderStage stage)
 	: m_stage(stage)
 {
+	m_hlsl_options.opt_level = 3;
 }
 
-bool ShaderValidator::Validate(const std::string& code, bool is_glsl, std::ostream& out) const
+bool ShaderValidator::Validate(std::string_view code, bool is_glsl, std::ostream& out) const
 {
 	if (is_glsl) 
 	{
-		if (!m_glsl) {
-			m_glsl = std::make_unique<CompilerGLSL>(m_stage);
+		std::unique_ptr<CompilerGLSL> compiler;
+		{
+			std::lock_guard<std::mutex> lock(m_glsl_mutex);
+			if (!m_glsl_pool.empty()) {
+				compiler = std::move(m_glsl_pool.back());
+				m_glsl_pool.pop_back();
+			}
+		}
+		if (!compiler) {
+			compiler = std::make_unique<CompilerGLSL>(m_stage);
 		}
-		return m_glsl->Validate(code, out);
+
+		bool ret = compiler->Validate(code, out);
+
+		std::lock_guard<std::mutex> lock(m_glsl_mutex);
+		m_glsl_pool.push_back(std::move(compiler));
+
+		return ret;
 	} 
 	else 
 	{
-		std::vector<const wchar_t*> dxcArgs;
-		dxcArgs.push_back(L"-Zpr");
-		dxcArgs.push_back(L"-O3");
-		dxcArgs.push_back(L"-spirv");
+		if (!shadertrans::CompilerDX::Instance().IsAvailable()) {
+			out << shadertrans::CompilerDX::Instance().GetLoadError() << "\n";
+			return false;
+		}
+
+		auto dx = shadertrans::CompilerDX::Instance().Acquire();
 
 		CComPtr<IDxcBlobEncoding> sourceBlob;
-		IFT(shadertrans::CompilerDX::Instance().Library()->CreateBlobWithEncodingOnHeapCopy(code.c_str(), code.size(),
+		IFT(dx.Library()->CreateBlobWithEncodingOnHeapCopy(code.data(), static_cast<UINT32>(code.size()),
 			CP_UTF8, &sourceBlob));
 		IFTARG(sourceBlob->GetBufferSize() >= 4);
 
@@ -51,13 +68,15 @@ bool ShaderValidator::Validate(const std::string& code, bool is_glsl, std::ostre
 
 		std::wstring shaderProfile = hlsl_shader_profile_name(m_stage, 6, 0);
 
-		std::vector<DxcDefine> dxcDefines;
-		//CComPtr<IDxcIncludeHandler> includeHandler = new hlsl::ScIncludeHandler(std::move(hlsl::DefaultLoadCallback));
-		CComPtr<IDxcIncludeHandler> includeHandler = nullptr;
+		DxcArguments dxcArgs(m_hlsl_options);
+		auto& args = dxcArgs.Args();
+		auto& defines = dxcArgs.Defines();
+
+		CComPtr<IDxcIncludeHandler> includeHandler = new ScIncludeHandler(dx.Library(), DefaultLoadCallback);
 		CComPtr<IDxcOperationResult> compileResult;
-		IFT(shadertrans::CompilerDX::Instance().Compiler()->Compile(sourceBlob, nullptr, entryPointUtf16.c_str(), shaderProfile.c_str(),
-			dxcArgs.data(), static_cast<UINT32>(dxcArgs.size()), dxcDefines.data(),
-			static_cast<UINT32>(dxcDefines.size()), includeHandler, &compileResult));
+		IFT(dx.Compiler()->Compile(sourceBlob, nullptr, entryPointUtf16.c_str(), shaderProfile.c_str(),
+			const_cast<LPCWSTR*>(args.data()), static_cast<UINT32>(args.size()), defines.data(),
+			static_cast<UINT32>(defines.size()), includeHandler, &compileResult));
 
 		CComPtr<IDxcBlobEncoding> errors;
 		IFT(compileResult->GetErrorBuffer(&errors));
@@ -92,10 +111,11 @@ ShaderValidator::CompilerGLSL::~CompilerGLSL()
 	ShFinalize();
 }
 
-bool ShaderValidator::CompilerGLSL::Validate(const std::string& code, std::ostream& out) const
+bool ShaderValidator::CompilerGLSL::Validate(std::string_view code, std::ostream& out) const
 {
-	const char* shader_str = code.c_str();
-	int ret = ShCompile(m_compiler, &shader_str, 1, nullptr, EShOptNone,
+	const char* shader_str = code.data();
+	const int shader_len = static_cast<int>(code.size());
+	int ret = ShCompile(m_compiler, &shader_str, 1, &shader_len, EShOptNone,
 		&glsl::DefaultTBuiltInResource, 0, 100, false, EShMsgDefault);
 
 	out << ShGetInfoLog(m_compiler) << "\n";
@@ -1,20 +1,153 @@
 #include "shadertrans/SpirvTools.h"
 
 #include <spirv-tools/libspirv.hpp>
+#include <spirv-tools/optimizer.hpp>
+
+#include <iostream>
+#include <memory>
+#include <map>
+
+namespace
+{
+
+spv_target_env to_spv_env(shadertrans::TargetEnv env)
+{
+	switch (env)
+	{
+	case shadertrans::TargetEnv::Vulkan_1_0:
+		return SPV_ENV_VULKAN_1_0;
+	case shadertrans::TargetEnv::Vulkan_1_1:
+		return SPV_ENV_VULKAN_1_1;
+	case shadertrans::TargetEnv::Vulkan_1_1_Spirv_1_4:
+		return SPV_ENV_VULKAN_1_1_SPIRV_1_4;
+	case shadertrans::TargetEnv::Vulkan_1_2:
+		return SPV_ENV_VULKAN_1_2;
+	case shadertrans::TargetEnv::Vulkan_1_3:
+		return SPV_ENV_VULKAN_1_3;
+	default:
+		return SPV_ENV_UNIVERSAL_1_5;
+	}
+}
+
+void print_message(spv_message_level_t level, const char*,
+	const spv_position_t& position, const char* message)
+{
+	switch (level) {
+	case SPV_MSG_FATAL:
+	case SPV_MSG_INTERNAL_ERROR:
+	case SPV_MSG_ERROR:
+		std::cerr << "error: " << position.index << ": " << message
+			<< std::endl;
+		break;
+	case SPV_MSG_WARNING:
+		std::cout << "warning: " << position.index << ": " << message
+			<< std::endl;
+		break;
+	case SPV_MSG_INFO:
+		std::cout << "info: " << position.index << ": " << message << std::endl;
+		break;
+	default:
+		break;
+	}
+}
+
+bool optimize(std::vector<uint32_t>& spirv, const shadertrans::SpirvTools::OptimizeOptions& options,
+	spv_target_env env, std::ostream& out)
+{
+	if (options.preset == shadertrans::SpirvTools::Optimization::None || spirv.empty()) {
+		return true;
+	}
+
+	spvtools::Optimizer optimizer(env);
+	optimizer.SetMessageConsumer([&out](spv_message_level_t level, const char*,
+		                                const spv_position_t& position, const char* message) {
+		if (level <= SPV_MSG_ERROR) {
+			out << "error: " << position.index << ": " << message << "\n";
+		}
+	});
+
+	switch (options.preset)
+	{
+	case shadertrans::SpirvTools::Optimization::Size:
+		optimizer.RegisterSizePasses();
+		break;
+	case shadertrans::SpirvTools::Optimization::Performance:
+		optimizer.RegisterPerformancePasses();
+		break;
+	case shadertrans::SpirvTools::Optimization::Custom:
+		if (!optimizer.RegisterPassesFromFlags(options.passes)) {
+			out << "invalid optimizer passes\n";
+			return false;
+		}
+		break;
+	default:
+		break;
+	}
+
+	std::vector<uint32_t> optimized;
+	if (!optimizer.Run(spirv.data(), spirv.size(), &optimized)) {
+		return false;
+	}
+
+	spirv.swap(optimized);
+	return true;
+}
+
+const spvtools::Context& link_context(spv_target_env env)
+{
+	thread_local std::map<spv_target_env, std::unique_ptr<spvtools::Context>> contexts;
+
+	auto& context = contexts[env];
+	if (!context)
+	{
+		context = std::make_unique<spvtools::Context>(env);
+		context->SetMessageConsumer(print_message);
+	}
+	return *context;
+}
+
+}
 
 namespace shadertrans
 {
 
 bool SpirvTools::Assemble(const char* text, size_t text_size, std::vector<uint32_t>* binary)
 {
-	spvtools::SpirvTools tools(SPV_ENV_UNIVERSAL_1_0);
-	return tools.Assemble(text, text_size, binary);
+	return Tools().Assemble(text, text_size, binary);
 }
 
 bool SpirvTools::Disassemble(const uint32_t* binary, size_t binary_size, std::string* text)
 {
-	spvtools::SpirvTools tools(SPV_ENV_UNIVERSAL_1_0);
-	return tools.Disassemble(binary, binary_size, text);
+	return Tools().Disassemble(binary, binary_size, text);
+}
+
+bool SpirvTools::Optimize(std::vector<uint32_t>& spirv, const OptimizeOptions& options, std::ostream& out)
+{
+	return optimize(spirv, options, SPV_ENV_UNIVERSAL_1_5, out);
+}
+
+bool SpirvTools::Optimize(std::vector<uint32_t>& spirv, const OptimizeOptions& options, TargetEnv env, std::ostream& out)
+{
+	return optimize(spirv, options, to_spv_env(env), out);
+}
+
+const spvtools::SpirvTools& SpirvTools::Tools()
+{
+	thread_local std::unique_ptr<spvtools::SpirvTools> tools;
+	if (!tools) {
+		tools = std::make_unique<spvtools::SpirvTools>(SPV_ENV_UNIVERSAL_1_0);
+	}
+	return *tools;
+}
+
+const spvtools::Context& SpirvTools::LinkContext()
+{
+	return link_context(SPV_ENV_UNIVERSAL_1_5);
+}
+
+const spvtools::Context& SpirvTools::LinkContext(TargetEnv env)
+{
+	return link_context(to_spv_env(env));
 }
 
 }
\ No newline at end of file
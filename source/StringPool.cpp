@@ -0,0 +1,61 @@
+#include "shadertrans/StringPool.h"
+
+#include <algorithm>
+
+#include <string.h>
+
+namespace shadertrans
+{
+
+StringPool::Handle StringPool::Intern(std::string_view str)
+{
+	auto itr = m_lookup.find(str);
+	if (itr != m_lookup.end()) {
+		return itr->second;
+	}
+
+	const Handle handle = static_cast<Handle>(m_strings.size());
+	std::string_view stored(Store(str), str.size());
+	m_strings.push_back(stored);
+	m_lookup.insert({ stored, handle });
+	return handle;
+}
+
+StringPool::Handle StringPool::Find(std::string_view str) const
+{
+	auto itr = m_lookup.find(str);
+	return itr == m_lookup.end() ? INVALID : itr->second;
+}
+
+void StringPool::Clear()
+{
+	m_chunks.clear();
+	m_chunk_used = m_chunk_cap = 0;
+
+	m_strings.clear();
+	m_lookup.clear();
+
+	m_bytes = 0;
+}
+
+const char* StringPool::Store(std::string_view str)
+{
+	const size_t size = str.size() + 1;
+	if (m_chunks.empty() || m_chunk_used + size > m_chunk_cap)
+	{
+		m_chunk_cap = std::max(CHUNK_SIZE, size);
+		m_chunks.emplace_back(new char[m_chunk_cap]);
+		m_chunk_used = 0;
+	}
+
+	char* dst = m_chunks.back().get() + m_chunk_used;
+	memcpy(dst, str.data(), str.size());
+	dst[str.size()] = 0;
+
+	m_chunk_used += size;
+	m_bytes += size;
+
+	return dst;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,161 @@
+#include "shadertrans/StringReplacer.h"
+
+#include <queue>
+
+namespace shadertrans
+{
+
+StringReplacer::StringReplacer(const std::vector<std::pair<std::string, std::string>>& table)
+{
+	m_patterns.reserve(table.size());
+	for (auto& item : table)
+	{
+		if (item.first.empty()) {
+			continue;
+		}
+
+		bool dup = false;
+		for (auto& p : m_patterns) {
+			if (p.first == item.first) {
+				dup = true;
+				break;
+			}
+		}
+		if (!dup) {
+			m_patterns.push_back(item);
+		}
+	}
+
+	Build();
+}
+
+std::string StringReplacer::Apply(std::string_view str) const
+{
+	std::string ret;
+	Apply(str, ret);
+	return ret;
+}
+
+void StringReplacer::Apply(std::string_view str, std::string& out) const
+{
+	out.reserve(out.size() + str.size());
+	if (m_patterns.empty()) {
+		out.append(str.data(), str.size());
+		return;
+	}
+
+	const size_t NONE = std::string_view::npos;
+
+	size_t copied = 0;
+	size_t cand_start = NONE, cand_len = 0;
+	int32_t cand_pattern = -1;
+
+	int32_t state = 0;
+	for (size_t i = 0, n = str.size(); i <= n; ++i)
+	{
+		bool commit = false;
+		if (i < n)
+		{
+			state = m_next[state][static_cast<uint8_t>(str[i])];
+
+			const int32_t pattern = m_output[state];
+			if (pattern >= 0)
+			{
+				const size_t len = m_patterns[pattern].first.size();
+				const size_t start = i + 1 - len;
+				if (cand_start == NONE || start < cand_start || (start == cand_start && len > cand_len))
+				{
+					cand_start = start;
+					cand_len = len;
+					cand_pattern = pattern;
+				}
+			}
+
+			// no match still in progress can start at or before the candidate
+			commit = cand_start != NONE && i + 1 - m_depth[state] > cand_start;
+		}
+		else
+		{
+			commit = cand_start != NONE;
+		}
+
+		if (commit)
+		{
+			out.append(str.data() + copied, cand_start - copied);
+			out += m_patterns[cand_pattern].second;
+			copied = cand_start + cand_len;
+
+			// rescan what followed the match, less than the longest
+			// pattern, see the class comment for the bound
+			i = copied - 1;
+			state = 0;
+			cand_start = NONE;
+		}
+	}
+
+	out.append(str.data() + copied, str.size() - copied);
+}
+
+void StringReplacer::Build()
+{
+	std::array<int32_t, 256> empty;
+	empty.fill(-1);
+
+	m_next.assign(1, empty);
+	m_depth.assign(1, 0);
+	m_output.assign(1, -1);
+
+	// trie
+	for (size_t i = 0, n = m_patterns.size(); i < n; ++i)
+	{
+		int32_t state = 0;
+		for (auto c : m_patterns[i].first)
+		{
+			auto& next = m_next[state][static_cast<uint8_t>(c)];
+			if (next < 0)
+			{
+				next = static_cast<int32_t>(m_next.size());
+				m_next.push_back(empty);
+				m_depth.push_back(m_depth[state] + 1);
+				m_output.push_back(-1);
+			}
+			state = next;
+		}
+		m_output[state] = static_cast<int32_t>(i);
+	}
+
+	// failure links folded into the transitions, bfs so that a state's
+	// fallback is complete before its children use it
+	std::vector<int32_t> fail(m_next.size(), 0);
+	std::queue<int32_t> buf;
+	for (auto& next : m_next[0])
+	{
+		if (next < 0) {
+			next = 0;
+		} else {
+			buf.push(next);
+		}
+	}
+	while (!buf.empty())
+	{
+		const int32_t state = buf.front();
+		buf.pop();
+
+		if (m_output[state] < 0) {
+			m_output[state] = m_output[fail[state]];
+		}
+
+		for (int c = 0; c < 256; ++c)
+		{
+			auto& next = m_next[state][c];
+			if (next < 0) {
+				next = m_next[fail[state]][c];
+			} else {
+				fail[next] = m_next[fail[state]][c];
+				buf.push(next);
+			}
+		}
+	}
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,196 @@
+#include "shadertrans/UniformIndex.h"
+#include "shadertrans/Hasher.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace
+{
+
+size_t next_pow2(size_t n)
+{
+	size_t ret = 1;
+	while (ret < n) {
+		ret <<= 1;
+	}
+	return ret;
+}
+
+const uint32_t MAX_DISP = 1 << 16;
+
+}
+
+namespace shadertrans
+{
+
+bool UniformIndex::Build(const ReflectionContext& ctx, const ReflectionContext::UniformTable& table, bool perfect)
+{
+	m_ctx = &ctx;
+	m_entries.clear();
+	m_hashes.clear();
+	m_slots.clear();
+	m_disp.clear();
+
+	// an array of structs and its elements share one name, keep the
+	// first, which is the array
+	std::unordered_map<uint64_t, ReflectionContext::Handle> added;
+	for (size_t i = 0, n = table.variables.size(); i < n; ++i)
+	{
+		auto& var = table.variables[i];
+		const uint64_t hash = HashName(ctx.GetName(var.name));
+		auto itr = added.emplace(hash, var.name);
+		if (!itr.second)
+		{
+			if (itr.first->second == var.name) {
+				continue;
+			}
+			m_entries.clear();
+			m_hashes.clear();
+			return false;
+		}
+
+		const uint32_t first = var.parent == ReflectionContext::INVALID_INDEX
+			? 0 : table.variables[var.parent].first_child;
+
+		Entry e;
+		e.name    = var.name;
+		e.binding = var.binding;
+		e.member  = static_cast<uint32_t>(i) - first;
+		e.row     = static_cast<uint32_t>(i);
+		e.type    = var.type;
+		m_entries.push_back(e);
+		m_hashes.push_back(hash);
+	}
+
+	if (perfect)
+	{
+		for (size_t slot_count = next_pow2(m_entries.size()); ; slot_count *= 2) {
+			if (BuildPerfect(slot_count)) {
+				return true;
+			}
+		}
+	}
+
+	// linear probing, at most half full
+	m_slots.resize(next_pow2(m_entries.size() * 2));
+	const size_t mask = m_slots.size() - 1;
+	for (size_t i = 0, n = m_entries.size(); i < n; ++i)
+	{
+		size_t pos = m_hashes[i] & mask;
+		while (m_slots[pos].entry != EMPTY) {
+			pos = (pos + 1) & mask;
+		}
+		m_slots[pos].hash  = m_hashes[i];
+		m_slots[pos].entry = static_cast<uint32_t>(i);
+	}
+	return true;
+}
+
+const UniformIndex::Entry* UniformIndex::Find(std::string_view path) const
+{
+	auto e = Find(HashName(path));
+	return e && m_ctx->GetName(e->name) == path ? e : nullptr;
+}
+
+const UniformIndex::Entry* UniformIndex::Find(uint64_t hash) const
+{
+	if (m_slots.empty()) {
+		return nullptr;
+	}
+
+	const size_t mask = m_slots.size() - 1;
+	if (!m_disp.empty())
+	{
+		auto& slot = m_slots[Mix(hash, m_disp[hash & (m_disp.size() - 1)]) & mask];
+		return slot.entry != EMPTY && slot.hash == hash ? &m_entries[slot.entry] : nullptr;
+	}
+
+	for (size_t pos = hash & mask; m_slots[pos].entry != EMPTY; pos = (pos + 1) & mask) {
+		if (m_slots[pos].hash == hash) {
+			return &m_entries[m_slots[pos].entry];
+		}
+	}
+	return nullptr;
+}
+
+uint64_t UniformIndex::HashName(std::string_view path)
+{
+	return Hasher().Update(path.data(), path.size()).Digest();
+}
+
+bool UniformIndex::BuildPerfect(size_t slot_count)
+{
+	// hash and displace: group keys into buckets, then place the biggest
+	// buckets first, each with the first displacement that fits
+	const size_t bucket_count = next_pow2(std::max<size_t>(1, m_entries.size() / 4));
+
+	std::vector<std::vector<uint32_t>> buckets(bucket_count);
+	for (size_t i = 0, n = m_hashes.size(); i < n; ++i) {
+		buckets[m_hashes[i] & (bucket_count - 1)].push_back(static_cast<uint32_t>(i));
+	}
+
+	std::vector<uint32_t> order(bucket_count);
+	for (size_t i = 0; i < bucket_count; ++i) {
+		order[i] = static_cast<uint32_t>(i);
+	}
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+		return buckets[a].size() > buckets[b].size();
+	});
+
+	m_slots.assign(slot_count, Slot());
+	m_disp.assign(bucket_count, 0);
+
+	const size_t mask = slot_count - 1;
+	std::vector<size_t> pos;
+	for (auto b : order)
+	{
+		auto& keys = buckets[b];
+		if (keys.empty()) {
+			break;
+		}
+
+		bool placed = false;
+		for (uint32_t disp = 0; disp < MAX_DISP && !placed; ++disp)
+		{
+			pos.clear();
+			placed = true;
+			for (auto k : keys)
+			{
+				const size_t p = Mix(m_hashes[k], disp) & mask;
+				if (m_slots[p].entry != EMPTY || std::find(pos.begin(), pos.end(), p) != pos.end()) {
+					placed = false;
+					break;
+				}
+				pos.push_back(p);
+			}
+
+			if (placed)
+			{
+				m_disp[b] = disp;
+				for (size_t i = 0; i < keys.size(); ++i) {
+					m_slots[pos[i]].hash  = m_hashes[keys[i]];
+					m_slots[pos[i]].entry = keys[i];
+				}
+			}
+		}
+
+		if (!placed) {
+			m_slots.clear();
+			m_disp.clear();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+uint64_t UniformIndex::Mix(uint64_t hash, uint32_t disp)
+{
+	uint64_t x = hash ^ (disp * 0x9e3779b97f4a7c15ull);
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdull;
+	x ^= x >> 33;
+	return x;
+}
+
+}
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "shadertrans/spirv_Linker.h"
 #include "shadertrans/spirv_Parser.h"
 #include "shadertrans/ShaderTrans.h"
+#include "shadertrans/SpirvTools.h"
 
 #include <spirv_cross.hpp>
 #include <spirv-tools/linker.hpp>
@@ -10,15 +11,26 @@ namespace shadertrans
 namespace spirv
 {
 
-void Linker::AddModule(ShaderStage stage, const std::string& glsl)
+void Linker::AddModule(ShaderStage stage, std::string_view glsl)
 {
+    ShaderTrans::GLSLOptions options;
+    options.no_link    = true;
+    options.target_env = m_target_env;
+
     std::vector<unsigned int> spv;
-    ShaderTrans::GLSL2SpirV(stage, glsl, nullptr, spv, true);
+    ShaderTrans::GLSL2SpirV(stage, glsl, nullptr, options, spv);
 
     //std::string str;
     //ShaderTrans::SpirV2GLSL(stage, spv, str);
     //printf("new:\n%s\n", str.c_str());
 
+	auto module = std::make_shared<spirv::Module>();
+	Parser::Parse(std::move(spv), *module);
+	m_modules.push_back(module);
+}
+
+void Linker::AddModule(SpirvSpan spv)
+{
 	auto module = std::make_shared<spirv::Module>();
 	Parser::Parse(spv, *module);
 	m_modules.push_back(module);
@@ -26,40 +38,22 @@ void Linker::AddModule(ShaderStage stage, const std::string& glsl)
 
 void Linker::Link()
 {
-    const spvtools::MessageConsumer consumer = [](spv_message_level_t level,
-        const char*,
-        const spv_position_t& position,
-        const char* message) {
-            switch (level) {
-            case SPV_MSG_FATAL:
-            case SPV_MSG_INTERNAL_ERROR:
-            case SPV_MSG_ERROR:
-                std::cerr << "error: " << position.index << ": " << message
-                    << std::endl;
-                break;
-            case SPV_MSG_WARNING:
-                std::cout << "warning: " << position.index << ": " << message
-                    << std::endl;
-                break;
-            case SPV_MSG_INFO:
-                std::cout << "info: " << position.index << ": " << message << std::endl;
-                break;
-            default:
-                break;
-            }
-    };
-	spvtools::Context context(SPV_ENV_UNIVERSAL_1_5);
-	context.SetMessageConsumer(consumer);
-
-    std::vector<std::vector<uint32_t>> contents;
-    for (auto& m : m_modules) {
-        contents.push_back(m->spv);
+    // hand spvtools the module words in place instead of copying them
+    std::vector<const uint32_t*> binaries;
+    std::vector<size_t> binary_sizes;
+    binaries.reserve(m_modules.size());
+    binary_sizes.reserve(m_modules.size());
+    for (auto& m : m_modules)
+    {
+        auto words = m->GetSpirv();
+        binaries.push_back(words.data());
+        binary_sizes.push_back(words.size());
     }
 
     spvtools::LinkerOptions options;
 
 	std::vector<uint32_t> ret;
-	spv_result_t status = spvtools::Link(context, contents, &ret, options);
+	spv_result_t status = spvtools::Link(SpirvTools::LinkContext(m_target_env), binaries.data(), binary_sizes.data(), binaries.size(), &ret, options);
 }
 
 }
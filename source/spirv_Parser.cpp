@@ -1,8 +1,8 @@
 #include "shadertrans/spirv_Parser.h"
+#include "shadertrans/MappedFile.h"
+#include "spirv_Words.h"
 
 #include <spirv/unified1/spirv.hpp>
-#include <unordered_map>
-#include <functional>
 
 typedef unsigned int spv_word;
 
@@ -13,6 +13,11 @@ namespace spirv
 
 std::string spvReadString(const unsigned int* data, int length, int& i)
 {
+	// an OpName or OpMemberName too short to hold any string
+	if (length <= 0) {
+		return std::string();
+	}
+
 	std::string ret(length * 4, 0);
 
 	for (int j = 0; j < length; j++, i++) {
@@ -32,10 +37,125 @@ std::string spvReadString(const unsigned int* data, int length, int& i)
 	return ret;
 }
 
+namespace
+{
+
+typedef std::pair<ValueType, int> TypeInfo;
+
+struct IdInfo
+{
+	std::string name;
+	spv_word pointee = 0;	// 0: not a pointer type
+	TypeInfo type;
+};
+
+class IdTables
+{
+public:
+	IdTables(SpirvSpan spv) {
+		m_ids.Reset(spv);
+	}
+
+	const std::string& Name(spv_word id) const {
+		static const std::string EMPTY;
+		auto info = m_ids.Find(id);
+		return info ? info->name : EMPTY;
+	}
+	const TypeInfo& Type(spv_word id) const {
+		static const TypeInfo UNKNOWN(ValueType::Void, 0);
+		auto info = m_ids.Find(id);
+		return info ? info->type : UNKNOWN;
+	}
+	spv_word Pointee(spv_word id) const {
+		auto info = m_ids.Find(id);
+		return info ? info->pointee : 0;
+	}
+
+	void SetName(spv_word id, std::string&& name) {
+		m_ids.Get(id).name = std::move(name);
+	}
+	void SetType(spv_word id, const TypeInfo& type) {
+		m_ids.Get(id).type = type;
+	}
+	void SetPointer(spv_word id, spv_word pointee) {
+		m_ids.Get(id).pointee = pointee;
+	}
+
+private:
+	IdTable<IdInfo> m_ids;
+
+}; // IdTables
+
+void fetch_type(const IdTables& ids, Variable& var, spv_word type)
+{
+	spv_word actualType = type;
+	if (spv_word pointee = ids.Pointee(type))
+		actualType = pointee;
+
+	const TypeInfo& info = ids.Type(actualType);
+	var.type = info.first;
+	var.base_type = var.type;
+
+	if (var.type == ValueType::Struct)
+	{
+		var.type_name = ids.Name(info.second);
+	}
+	else if (var.type == ValueType::Vector)
+	{
+		var.type_comp_count = info.second & 0x00ffffff;
+		var.base_type = (ValueType)((info.second & 0xff000000) >> 24);
+	}
+	else if (var.type == ValueType::Matrix)
+	{
+		var.type_comp_count = info.second & 0x00ffffff;
+		var.base_type = ValueType::Matrix;
+	}
+}
+
+}
+
 void Parser::Parse(const std::vector<unsigned int>& ir, Module& module)
 {
 	module.spv = ir;
+	module.spv_view = SpirvSpan();
+	module.spv_holder.reset();
 
+	ParseWords(module.spv, module);
+}
+
+void Parser::Parse(std::vector<unsigned int>&& ir, Module& module)
+{
+	module.spv = std::move(ir);
+	module.spv_view = SpirvSpan();
+	module.spv_holder.reset();
+
+	ParseWords(module.spv, module);
+}
+
+void Parser::Parse(SpirvSpan ir, Module& module)
+{
+	std::vector<unsigned int>().swap(module.spv);
+	module.spv_view = ir;
+	module.spv_holder.reset();
+
+	ParseWords(ir, module);
+}
+
+bool Parser::ParseFile(const std::string& filepath, Module& module)
+{
+	auto file = std::make_shared<MappedFile>(filepath);
+	if (!file->IsValid()) {
+		return false;
+	}
+
+	Parse(file->Words(), module);
+	module.spv_holder = file;
+
+	return true;
+}
+
+void Parser::ParseWords(SpirvSpan ir, Module& module)
+{
 	module.functions.clear();
 	module.user_types.clear();
 	module.uniforms.clear();
@@ -53,80 +173,64 @@ void Parser::Parse(const std::vector<unsigned int>& ir, Module& module)
 	module.local_size_y = 1;
 	module.local_size_z = 1;
 
-	std::string curFunc = "";
-	int lastOpLine = -1;
+	if (ir.size() < 5) {
+		return;
+	}
 
-	std::unordered_map<spv_word, std::string> names;
-	std::unordered_map<spv_word, spv_word> pointers;
-	std::unordered_map<spv_word, std::pair<ValueType, int>> types;
-
-	std::function<void(Variable&, spv_word)> fetchType = [&](Variable& var, spv_word type) {
-		spv_word actualType = type;
-		if (pointers.count(type))
-			actualType = pointers[type];
-
-		const std::pair<ValueType, int>& info = types[actualType];
-		var.type = info.first;
-		var.base_type = var.type;
-			
-		if (var.type == ValueType::Struct)
-		{
-			var.type_name = names[info.second];
-		}
-		else if (var.type == ValueType::Vector) 
-		{
-			var.type_comp_count = info.second & 0x00ffffff;
-			var.base_type = (ValueType)((info.second & 0xff000000) >> 24);
-		} 
-		else if (var.type == ValueType::Matrix)
-		{
-			var.type_comp_count = info.second & 0x00ffffff;
-			var.base_type = ValueType::Matrix;
-		}
-	};
+	// current function, the named flag keeps the old behavior of treating
+	// the body of an unnamed function as global scope
+	Function* curFunc = nullptr;
+	bool curFuncNamed = false;
+	int lastOpLine = -1;
 
-	for (int i = 5; i < ir.size();) {
-		int iStart = i;
-		spv_word opcodeData = ir[i];
+	IdTables ids(ir);
 
-		spv_word wordCount = ((opcodeData & (~spv::OpCodeMask)) >> spv::WordCountShift) - 1;
-		spv_word opcode = (opcodeData & spv::OpCodeMask);
+	WordScanner scanner(ir);
+	Instruction inst;
+	while (scanner.Next(inst)) {
+		size_t i = inst.offset;
+		spv_word wordCount = inst.word_count - 1;
+		spv_word opcode = inst.op;
 
 		switch (opcode) {
 		case spv::OpName: {
 			spv_word loc = ir[++i];
 			spv_word stringLength = wordCount - 1;
 
-			names[loc] = spvReadString(ir.data(), stringLength, ++i);
+			int pos = static_cast<int>(++i);
+			ids.SetName(loc, spvReadString(ir.data(), stringLength, pos));
 		} break;
 		case spv::OpLine: {
 			++i; // skip file
 			lastOpLine = ir[++i];
 
-			if (!curFunc.empty() && module.functions[curFunc].line_start == -1)
-				module.functions[curFunc].line_start = lastOpLine;
+			if (curFuncNamed && curFunc->line_start == -1)
+				curFunc->line_start = lastOpLine;
 		} break;
 		case spv::OpTypeStruct: {
 			spv_word loc = ir[++i];
 
+			const std::string& name = ids.Name(loc);
+
 			spv_word memCount = wordCount - 1;
-			if (module.user_types.count(names[loc]) == 0) {
+			auto itr = module.user_types.find(name);
+			if (itr == module.user_types.end()) {
 				std::vector<Variable> mems(memCount);
 				for (spv_word j = 0; j < memCount; j++) {
 					spv_word type = ir[++i];
-					fetchType(mems[j], type);
+					fetch_type(ids, mems[j], type);
 				}
 
-				module.user_types.insert(std::make_pair(names[loc], mems));
+				module.user_types.insert(std::make_pair(name, std::move(mems)));
 			} else {
-				auto& typeInfo = module.user_types[names[loc]];
+				auto& typeInfo = itr->second;
 				for (spv_word j = 0; j < memCount && j < typeInfo.size(); j++) {
 					spv_word type = ir[++i];
-					fetchType(typeInfo[j], type);
+					fetch_type(ids, typeInfo[j], type);
 				}
 			}
 
-			types[loc] = std::make_pair(ValueType::Struct, loc);
+			ids.SetType(loc, TypeInfo(ValueType::Struct, loc));
 		} break;
 		case spv::OpMemberName: {
 			spv_word owner = ir[++i];
@@ -134,55 +238,59 @@ void Parser::Parse(const std::vector<unsigned int>& ir, Module& module)
 
 			spv_word stringLength = wordCount - 2;
 
-			auto& typeInfo = module.user_types[names[owner]];
-
-			if (index < typeInfo.size())
-				typeInfo[index].name = spvReadString(ir.data(), stringLength, ++i);
-			else {
+			auto& typeInfo = module.user_types[ids.Name(owner)];
+			if (index >= typeInfo.size())
 				typeInfo.resize(index + 1);
-				typeInfo[index].name = spvReadString(ir.data(), stringLength, ++i);
-			}
+
+			int pos = static_cast<int>(++i);
+			typeInfo[index].name = spvReadString(ir.data(), stringLength, pos);
 		} break;
 		case spv::OpFunction: {
 			spv_word type = ir[++i];
 			spv_word loc = ir[++i];
 
-			curFunc = names[loc];
-			size_t dot = curFunc.find_first_of('.');
+			std::string funcName = ids.Name(loc);
+			size_t dot = funcName.find_first_of('.');
 			if (dot != std::string::npos) {
-				curFunc = curFunc.substr(dot + 1);
+				funcName = funcName.substr(dot + 1);
 			}
-			size_t args = curFunc.find_first_of('(');
+			size_t args = funcName.find_first_of('(');
 			if (args != std::string::npos) {
-				curFunc = curFunc.substr(0, args);
+				funcName = funcName.substr(0, args);
 			}
 
-			fetchType(module.functions[curFunc].ret_type, type);
-			module.functions[curFunc].line_start = -1;
-			module.functions[curFunc].index = module.functions.size() - 1;
+			curFuncNamed = !funcName.empty();
+			curFunc = &module.functions[funcName];
+
+			fetch_type(ids, curFunc->ret_type, type);
+			curFunc->line_start = -1;
+			curFunc->index = module.functions.size() - 1;
 		} break;
 		case spv::OpFunctionEnd: {
-			module.functions[curFunc].line_end = lastOpLine;
+			if (curFunc) {
+				curFunc->line_end = lastOpLine;
+			}
 			lastOpLine = -1;
-			curFunc = "";
+			curFunc = nullptr;
+			curFuncNamed = false;
 		} break;
 		case spv::OpVariable: {
 			spv_word type = ir[++i];
 			spv_word loc = ir[++i];
 
-			std::string varName = names[loc];
+			const std::string& varName = ids.Name(loc);
 
-			if (curFunc.empty()) {
+			if (!curFuncNamed) {
 				spv::StorageClass sType = (spv::StorageClass)ir[++i];
 				if (sType == spv::StorageClassUniform || sType == spv::StorageClassUniformConstant) {
 					Variable uni;
 					uni.name = varName;
-					fetchType(uni, type);
+					fetch_type(ids, uni, type);
 
 					if (uni.name.size() == 0 || uni.name[0] == 0) {
-						if (module.user_types.count(uni.type_name) > 0) {
-							const std::vector<Variable>& mems = module.user_types[uni.type_name];
-							for (const auto& mem : mems)
+						auto itr = module.user_types.find(uni.type_name);
+						if (itr != module.user_types.end()) {
+							for (const auto& mem : itr->second)
 								module.uniforms.push_back(mem);
 						}
 					} else
@@ -190,68 +298,70 @@ void Parser::Parse(const std::vector<unsigned int>& ir, Module& module)
 				} else if (varName.size() > 0 && varName[0] != 0) {
 					Variable glob;
 					glob.name = varName;
-					fetchType(glob, type);
+					fetch_type(ids, glob, type);
 
 					module.globals.push_back(glob);
 				}
 			} else {
 				Variable loc;
 				loc.name = varName;
-				fetchType(loc, type);
-				module.functions[curFunc].locals.push_back(loc);
+				fetch_type(ids, loc, type);
+				curFunc->locals.push_back(loc);
 			}
 		} break;
 		case spv::OpFunctionParameter: {
 			spv_word type = ir[++i];
 			spv_word loc = ir[++i];
 
-			Variable arg;
-			arg.name = names[loc];
-			fetchType(arg, type);
-			module.functions[curFunc].arguments.push_back(arg);
+			if (curFunc) {
+				Variable arg;
+				arg.name = ids.Name(loc);
+				fetch_type(ids, arg, type);
+				curFunc->arguments.push_back(arg);
+			}
 		} break;
 		case spv::OpTypePointer: {
 			spv_word loc = ir[++i];
 			++i; // skip storage class
 			spv_word type = ir[++i];
 
-			pointers[loc] = type;
+			ids.SetPointer(loc, type);
 		} break;
 		case spv::OpTypeBool: {
 			spv_word loc = ir[++i];
-			types[loc] = std::make_pair(ValueType::Bool, 0);
+			ids.SetType(loc, TypeInfo(ValueType::Bool, 0));
 		} break;
 		case spv::OpTypeInt: {
 			spv_word loc = ir[++i];
-			types[loc] = std::make_pair(ValueType::Int, 0);
+			ids.SetType(loc, TypeInfo(ValueType::Int, 0));
 		} break;
 		case spv::OpTypeFloat: {
 			spv_word loc = ir[++i];
-			types[loc] = std::make_pair(ValueType::Float, 0);
+			ids.SetType(loc, TypeInfo(ValueType::Float, 0));
 		} break;
 		case spv::OpTypeVector: {
 			spv_word loc = ir[++i];
 			spv_word comp = ir[++i];
 			spv_word compcount = ir[++i];
 
-			spv_word val = (compcount & 0x00FFFFFF) | (((spv_word)types[comp].first) << 24);
+			spv_word val = (compcount & 0x00FFFFFF) | (((spv_word)ids.Type(comp).first) << 24);
 
-			types[loc] = std::make_pair(ValueType::Vector, val);
+			ids.SetType(loc, TypeInfo(ValueType::Vector, val));
 		} break;
 		case spv::OpTypeMatrix: {
 			spv_word loc = ir[++i];
 			spv_word comp = ir[++i];
 			spv_word compcount = ir[++i];
 
-			spv_word val = (compcount & 0x00FFFFFF) | (types[comp].second & 0xFF000000);
+			spv_word val = (compcount & 0x00FFFFFF) | (ids.Type(comp).second & 0xFF000000);
 
-			types[loc] = std::make_pair(ValueType::Matrix, val);
+			ids.SetType(loc, TypeInfo(ValueType::Matrix, val));
 		} break;
 		case spv::OpExecutionMode: {
 			++i; // skip
 			spv_word execMode = ir[++i];
 
-			if (execMode == spv::ExecutionMode::ExecutionModeLocalSize) {
+			if (execMode == spv::ExecutionMode::ExecutionModeLocalSize && wordCount >= 5) {
 				module.local_size_x = ir[++i];
 				module.local_size_y = ir[++i];
 				module.local_size_z = ir[++i];
@@ -363,8 +473,6 @@ void Parser::Parse(const std::vector<unsigned int>& ir, Module& module)
 			module.control_flow_inst_count++;
 			break;
 		}
-
-		i = iStart + wordCount + 1;
 	}
 }
 
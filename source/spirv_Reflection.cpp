@@ -0,0 +1,1142 @@
+#include "shadertrans/spirv_Reflection.h"
+#include "shadertrans/ShaderRename.h"
+#include "spirv_Words.h"
+
+#include <spirv/unified1/spirv.hpp>
+
+#include <algorithm>
+#include <charconv>
+
+namespace
+{
+
+using Variable = shadertrans::ShaderReflection::Variable;
+using VarType = shadertrans::ShaderReflection::VarType;
+
+const uint32_t INVALID = 0xffffffff;
+
+const uint32_t FLAG_BLOCK        = 0x1;
+const uint32_t FLAG_BUFFER_BLOCK = 0x2;
+
+struct Type
+{
+	spv::Op op = spv::OpNop;
+
+	// Int: width, signedness
+	// Float: width
+	// Vector, Matrix: component type, count
+	// Array: element type, length constant
+	// RuntimeArray: element type
+	// Pointer: storage class, pointee
+	// Image: sampled type, dim, sampled
+	// SampledImage: image type
+	uint32_t a = 0, b = 0, c = 0;
+
+	// Struct: range in Scanner::member_types
+	uint32_t first_member = 0, member_count = 0;
+};
+
+struct Id
+{
+	uint32_t name_word = 0, name_len = 0;
+
+	uint32_t type = INVALID;	// index in Scanner::types
+	uint32_t constant = 0;
+
+	uint32_t flags = 0;
+	uint32_t binding = 0;
+	uint32_t array_stride = 0;
+
+	// ranges in Scanner::member_names and Scanner::member_decos, after sorting
+	uint32_t first_member_name = 0, member_name_count = 0;
+	uint32_t first_member_deco = 0, member_deco_count = 0;
+};
+
+struct MemberName
+{
+	uint32_t owner, index;
+	uint32_t word, len;
+};
+
+struct MemberDeco
+{
+	uint32_t owner, index;
+	uint32_t deco, value;
+};
+
+struct GlobalVar
+{
+	uint32_t id, type;
+};
+
+struct Func
+{
+	uint32_t id, ret_type;
+	uint32_t first_param, param_count;
+};
+
+struct Param
+{
+	uint32_t id, type;
+};
+
+// the SPIRV-Cross view of a type: base type after stripping arrays
+struct BaseType
+{
+	enum Kind { Other, Void, Bool, Int, Float, Struct, Image, SampledImage, Sampler };
+
+	Kind kind = Other;
+	uint32_t vecsize = 1, columns = 1;
+};
+
+class Scanner
+{
+public:
+	bool Scan(shadertrans::SpirvSpan spv, bool need_funcs);
+
+	std::string Name(uint32_t id) const;
+	std::string MemberName(uint32_t id, uint32_t index) const;
+
+	// append to out instead of returning a new string, for building paths
+	void AppendName(uint32_t id, std::string& out) const;
+	void AppendMemberName(uint32_t id, uint32_t index, std::string& out) const;
+
+	bool HasMemberDecoration(uint32_t id, uint32_t index, uint32_t deco) const;
+	uint32_t GetMemberDecoration(uint32_t id, uint32_t index, uint32_t deco) const;
+	uint32_t GetArrayStride(uint32_t id) const {
+		auto info = FindId(id);
+		return info ? info->array_stride : 0;
+	}
+	uint32_t GetBinding(uint32_t id) const {
+		auto info = FindId(id);
+		return info ? info->binding : 0;
+	}
+	uint32_t GetFlags(uint32_t id) const {
+		auto info = FindId(id);
+		return info ? info->flags : 0;
+	}
+	uint32_t GetConstant(uint32_t id) const {
+		auto info = FindId(id);
+		return info ? info->constant : 0;
+	}
+
+	const Type* GetType(uint32_t id) const {
+		auto info = FindId(id);
+		return info && info->type != INVALID ? &types[info->type] : nullptr;
+	}
+
+	bool IsArray(uint32_t id) const {
+		auto type = GetType(id);
+		return type && (type->op == spv::OpTypeArray || type->op == spv::OpTypeRuntimeArray);
+	}
+	uint32_t StripArrays(uint32_t id) const {
+		while (IsArray(id)) {
+			id = GetType(id)->a;
+		}
+		return id;
+	}
+	// the outermost dimension, 0 for runtime arrays
+	uint32_t ArrayLength(uint32_t id) const {
+		auto type = GetType(id);
+		return type && type->op == spv::OpTypeArray ? GetConstant(type->b) : 0;
+	}
+
+	BaseType GetBaseType(uint32_t id) const;
+
+	// same sizes as Compiler::get_declared_struct_size() and
+	// Compiler::get_declared_struct_member_size()
+	uint32_t GetStructSize(uint32_t struct_id) const;
+	uint32_t GetMemberSize(uint32_t struct_id, uint32_t index) const;
+	uint32_t GetBasicSize(uint32_t type_id, uint32_t matrix_stride, bool row_major) const;
+
+	std::vector<Type> types;
+	std::vector<uint32_t> member_types;
+	std::vector<::MemberName> member_names;
+	std::vector<MemberDeco> member_decos;
+
+	std::vector<GlobalVar> variables;
+	std::vector<Func> funcs;
+	std::vector<Param> params;
+
+private:
+	std::string ReadString(uint32_t word, uint32_t len) const;
+	void AppendString(uint32_t word, uint32_t len, std::string& out) const;
+
+	Id& GetId(uint32_t id) {
+		return m_ids.Get(id);
+	}
+	const Id* FindId(uint32_t id) const {
+		return m_ids.Find(id);
+	}
+	Type& NewType(uint32_t id, spv::Op op) {
+		GetId(id).type = static_cast<uint32_t>(types.size());
+		types.emplace_back();
+		types.back().op = op;
+		return types.back();
+	}
+
+private:
+	shadertrans::SpirvSpan m_spv;
+
+	shadertrans::spirv::IdTable<Id> m_ids;
+
+}; // Scanner
+
+bool Scanner::Scan(shadertrans::SpirvSpan spv, bool need_funcs)
+{
+	if (spv.size() < 5 || spv[0] != spv::MagicNumber) {
+		return false;
+	}
+
+	m_spv = spv;
+	m_ids.Reset(spv);
+
+	bool in_func = false;
+
+	shadertrans::spirv::WordScanner scanner(spv);
+	shadertrans::spirv::Instruction inst;
+	while (scanner.Next(inst))
+	{
+		const uint32_t word_count = inst.word_count;
+		const uint32_t op = inst.op;
+		const size_t i = inst.offset;
+
+		const unsigned int* w = inst.words;
+		switch (op)
+		{
+		case spv::OpName:
+			GetId(w[1]).name_word = static_cast<uint32_t>(i + 2);
+			GetId(w[1]).name_len = word_count - 2;
+			break;
+		case spv::OpMemberName:
+			member_names.push_back({ w[1], w[2], static_cast<uint32_t>(i + 3), word_count - 3 });
+			break;
+
+		case spv::OpDecorate:
+			switch (w[2])
+			{
+			case spv::DecorationBlock:
+				GetId(w[1]).flags |= FLAG_BLOCK;
+				break;
+			case spv::DecorationBufferBlock:
+				GetId(w[1]).flags |= FLAG_BUFFER_BLOCK;
+				break;
+			case spv::DecorationBinding:
+				if (word_count > 3) {
+					GetId(w[1]).binding = w[3];
+				}
+				break;
+			case spv::DecorationArrayStride:
+				if (word_count > 3) {
+					GetId(w[1]).array_stride = w[3];
+				}
+				break;
+			}
+			break;
+		case spv::OpMemberDecorate:
+			switch (w[3])
+			{
+			case spv::DecorationOffset:
+			case spv::DecorationMatrixStride:
+				if (word_count > 4) {
+					member_decos.push_back({ w[1], w[2], w[3], w[4] });
+				}
+				break;
+			case spv::DecorationRowMajor:
+				member_decos.push_back({ w[1], w[2], w[3], 1 });
+				break;
+			}
+			break;
+
+		case spv::OpConstant:
+			GetId(w[2]).constant = w[3];
+			break;
+
+		case spv::OpTypeVoid:
+		case spv::OpTypeBool:
+		case spv::OpTypeSampler:
+			NewType(w[1], static_cast<spv::Op>(op));
+			break;
+		case spv::OpTypeInt: {
+			auto& t = NewType(w[1], spv::OpTypeInt);
+			t.a = w[2];
+			t.b = w[3];
+		} break;
+		case spv::OpTypeFloat:
+			NewType(w[1], spv::OpTypeFloat).a = w[2];
+			break;
+		case spv::OpTypeVector:
+		case spv::OpTypeMatrix:
+		case spv::OpTypeArray:
+		case spv::OpTypePointer: {
+			auto& t = NewType(w[1], static_cast<spv::Op>(op));
+			t.a = w[2];
+			t.b = w[3];
+		} break;
+		case spv::OpTypeRuntimeArray:
+		case spv::OpTypeSampledImage:
+			NewType(w[1], static_cast<spv::Op>(op)).a = w[2];
+			break;
+		case spv::OpTypeImage: {
+			auto& t = NewType(w[1], spv::OpTypeImage);
+			t.a = w[2];
+			t.b = w[3];
+			t.c = w[7];
+		} break;
+		case spv::OpTypeStruct: {
+			auto& t = NewType(w[1], spv::OpTypeStruct);
+			t.first_member = static_cast<uint32_t>(member_types.size());
+			t.member_count = word_count - 2;
+			member_types.insert(member_types.end(), w + 2, w + word_count);
+		} break;
+
+		case spv::OpVariable:
+			if (!in_func) {
+				variables.push_back({ w[2], w[1] });
+			}
+			break;
+
+		case spv::OpFunction:
+			if (!need_funcs) {
+				// everything global has been seen
+				scanner.Stop();
+				break;
+			}
+			in_func = true;
+			funcs.push_back({ w[2], w[1], static_cast<uint32_t>(params.size()), 0 });
+			break;
+		case spv::OpFunctionParameter:
+			if (!funcs.empty()) {
+				params.push_back({ w[2], w[1] });
+				++funcs.back().param_count;
+			}
+			break;
+		case spv::OpFunctionEnd:
+			in_func = false;
+			break;
+		}
+	}
+
+	std::stable_sort(member_names.begin(), member_names.end(), [](const ::MemberName& a, const ::MemberName& b) {
+		return a.owner < b.owner;
+	});
+	for (size_t i = 0; i < member_names.size(); )
+	{
+		auto& id = GetId(member_names[i].owner);
+		id.first_member_name = static_cast<uint32_t>(i);
+		while (i < member_names.size() && member_names[i].owner == member_names[id.first_member_name].owner) {
+			++i;
+		}
+		id.member_name_count = static_cast<uint32_t>(i) - id.first_member_name;
+	}
+
+	std::stable_sort(member_decos.begin(), member_decos.end(), [](const MemberDeco& a, const MemberDeco& b) {
+		return a.owner < b.owner;
+	});
+	for (size_t i = 0; i < member_decos.size(); )
+	{
+		auto& id = GetId(member_decos[i].owner);
+		id.first_member_deco = static_cast<uint32_t>(i);
+		while (i < member_decos.size() && member_decos[i].owner == member_decos[id.first_member_deco].owner) {
+			++i;
+		}
+		id.member_deco_count = static_cast<uint32_t>(i) - id.first_member_deco;
+	}
+
+	return true;
+}
+
+std::string Scanner::Name(uint32_t id) const
+{
+	std::string ret;
+	AppendName(id, ret);
+	return ret;
+}
+
+std::string Scanner::MemberName(uint32_t id, uint32_t index) const
+{
+	std::string ret;
+	AppendMemberName(id, index, ret);
+	return ret;
+}
+
+void Scanner::AppendName(uint32_t id, std::string& out) const
+{
+	auto info = FindId(id);
+	if (info && info->name_word != 0) {
+		AppendString(info->name_word, info->name_len, out);
+	}
+}
+
+void Scanner::AppendMemberName(uint32_t id, uint32_t index, std::string& out) const
+{
+	auto info = FindId(id);
+	if (!info) {
+		return;
+	}
+
+	// the last OpMemberName wins, as in SPIRV-Cross
+	const ::MemberName* last = nullptr;
+	for (uint32_t i = info->first_member_name, n = info->first_member_name + info->member_name_count; i < n; ++i) {
+		if (member_names[i].index == index) {
+			last = &member_names[i];
+		}
+	}
+	if (last) {
+		AppendString(last->word, last->len, out);
+	}
+}
+
+bool Scanner::HasMemberDecoration(uint32_t id, uint32_t index, uint32_t deco) const
+{
+	auto info = FindId(id);
+	if (!info) {
+		return false;
+	}
+
+	for (uint32_t i = info->first_member_deco, n = info->first_member_deco + info->member_deco_count; i < n; ++i) {
+		if (member_decos[i].index == index && member_decos[i].deco == deco) {
+			return true;
+		}
+	}
+	return false;
+}
+
+uint32_t Scanner::GetMemberDecoration(uint32_t id, uint32_t index, uint32_t deco) const
+{
+	auto info = FindId(id);
+	if (!info) {
+		return 0;
+	}
+
+	uint32_t ret = 0;
+	for (uint32_t i = info->first_member_deco, n = info->first_member_deco + info->member_deco_count; i < n; ++i) {
+		if (member_decos[i].index == index && member_decos[i].deco == deco) {
+			ret = member_decos[i].value;
+		}
+	}
+	return ret;
+}
+
+BaseType Scanner::GetBaseType(uint32_t id) const
+{
+	BaseType ret;
+
+	auto type = GetType(StripArrays(id));
+	if (!type) {
+		return ret;
+	}
+
+	switch (type->op)
+	{
+	case spv::OpTypeVoid:
+		ret.kind = BaseType::Void;
+		break;
+	case spv::OpTypeBool:
+		ret.kind = BaseType::Bool;
+		break;
+	case spv::OpTypeInt:
+		ret.kind = type->a == 32 ? BaseType::Int : BaseType::Other;
+		break;
+	case spv::OpTypeFloat:
+		ret.kind = type->a == 32 ? BaseType::Float : BaseType::Other;
+		break;
+	case spv::OpTypeVector:
+		ret = GetBaseType(type->a);
+		ret.vecsize = type->b;
+		break;
+	case spv::OpTypeMatrix:
+		ret = GetBaseType(type->a);
+		ret.columns = type->b;
+		break;
+	case spv::OpTypeStruct:
+		ret.kind = BaseType::Struct;
+		break;
+	case spv::OpTypeImage:
+		ret.kind = BaseType::Image;
+		break;
+	case spv::OpTypeSampledImage:
+		ret.kind = BaseType::SampledImage;
+		break;
+	case spv::OpTypeSampler:
+		ret.kind = BaseType::Sampler;
+		break;
+	default:
+		break;
+	}
+
+	return ret;
+}
+
+uint32_t Scanner::GetStructSize(uint32_t struct_id) const
+{
+	auto type = GetType(struct_id);
+	if (!type || type->op != spv::OpTypeStruct || type->member_count == 0) {
+		return 0;
+	}
+
+	const uint32_t last = type->member_count - 1;
+	return GetMemberDecoration(struct_id, last, spv::DecorationOffset) + GetMemberSize(struct_id, last);
+}
+
+uint32_t Scanner::GetMemberSize(uint32_t struct_id, uint32_t index) const
+{
+	auto struct_type = GetType(struct_id);
+	if (!struct_type || index >= struct_type->member_count) {
+		return 0;
+	}
+
+	const uint32_t member_id = member_types[struct_type->first_member + index];
+	auto type = GetType(member_id);
+	if (!type) {
+		return 0;
+	}
+
+	if (type->op == spv::OpTypeArray) {
+		return GetArrayStride(member_id) * GetConstant(type->b);
+	} else if (type->op == spv::OpTypeRuntimeArray) {
+		return 0;
+	} else if (type->op == spv::OpTypeStruct) {
+		return GetStructSize(member_id);
+	} else {
+		return GetBasicSize(member_id, GetMemberDecoration(struct_id, index, spv::DecorationMatrixStride),
+			HasMemberDecoration(struct_id, index, spv::DecorationRowMajor));
+	}
+}
+
+uint32_t Scanner::GetBasicSize(uint32_t type_id, uint32_t matrix_stride, bool row_major) const
+{
+	auto type = GetType(StripArrays(type_id));
+	if (!type) {
+		return 0;
+	}
+
+	switch (type->op)
+	{
+	case spv::OpTypeInt:
+	case spv::OpTypeFloat:
+		return type->a / 8;
+	case spv::OpTypeBool:
+		return 4;
+	case spv::OpTypeVector:
+		return type->b * GetBasicSize(type->a, 0, false);
+	case spv::OpTypeMatrix:
+		if (row_major) {
+			auto column = GetType(type->a);
+			return column ? matrix_stride * column->b : 0;
+		} else {
+			return matrix_stride * type->b;
+		}
+	default:
+		return 0;
+	}
+}
+
+std::string Scanner::ReadString(uint32_t word, uint32_t len) const
+{
+	std::string ret;
+	ret.reserve(len * 4);
+	AppendString(word, len, ret);
+	return ret;
+}
+
+void Scanner::AppendString(uint32_t word, uint32_t len, std::string& out) const
+{
+	for (uint32_t i = 0; i < len; ++i)
+	{
+		const uint32_t w = m_spv[word + i];
+		for (int j = 0; j < 4; ++j)
+		{
+			const char c = static_cast<char>((w >> (j * 8)) & 0xff);
+			if (c == 0) {
+				return;
+			}
+			out.push_back(c);
+		}
+	}
+}
+
+// same mapping as parse_spir_type() in ShaderReflection.cpp
+VarType parse_type(const Scanner& scan, uint32_t type_id)
+{
+	auto type = scan.GetBaseType(type_id);
+	switch (type.kind)
+	{
+	case BaseType::Bool:
+		if (type.columns == 1 && type.vecsize == 1) {
+			return VarType::Bool;
+		}
+		break;
+	case BaseType::Int:
+		switch (type.vecsize)
+		{
+		case 1:
+			return VarType::Int;
+		case 2:
+			return VarType::Int2;
+		case 3:
+			return VarType::Int3;
+		case 4:
+			return VarType::Int4;
+		}
+		break;
+	case BaseType::Float:
+		switch (type.columns)
+		{
+		case 1:
+			switch (type.vecsize)
+			{
+			case 1:
+				return VarType::Float;
+			case 2:
+				return VarType::Float2;
+			case 3:
+				return VarType::Float3;
+			case 4:
+				return VarType::Float4;
+			}
+			break;
+		case 2:
+			if (type.vecsize == 2) {
+				return VarType::Mat2;
+			}
+			break;
+		case 3:
+			if (type.vecsize == 3) {
+				return VarType::Mat3;
+			}
+			break;
+		case 4:
+			if (type.vecsize == 4) {
+				return VarType::Mat4;
+			}
+			break;
+		}
+		break;
+	default:
+		break;
+	}
+	return VarType::Unknown;
+}
+
+// Uniform trees are built either as ShaderReflection::Variable, with string
+// names, or as HandleNode, with names interned while scanning. The path of
+// the current node lives in one buffer that grows and shrinks with the
+// recursion, Namer turns it into the node's name.
+struct HandleNode
+{
+	shadertrans::ReflectionContext::Variable var;
+	std::vector<HandleNode> children;
+};
+
+Variable& fields(Variable& node) { return node; }
+shadertrans::ReflectionContext::Variable& fields(HandleNode& node) { return node.var; }
+
+void append_index(std::string& path, uint32_t index)
+{
+	char buf[16];
+	auto ret = std::to_chars(buf, buf + sizeof(buf), index);
+	path.push_back('[');
+	path.append(buf, ret.ptr);
+	path.push_back(']');
+}
+
+template <typename Node>
+void set_member_layout(const Scanner& scan, uint32_t struct_id, uint32_t index, uint32_t base_offset, Node& node)
+{
+	auto struct_type = scan.GetType(struct_id);
+
+	auto& var = fields(node);
+	var.offset = base_offset + scan.GetMemberDecoration(struct_id, index, spv::DecorationOffset);
+	var.size = scan.GetMemberSize(struct_id, index);
+	var.array_stride = scan.GetArrayStride(scan.member_types[struct_type->first_member + index]);
+	var.matrix_stride = scan.GetMemberDecoration(struct_id, index, spv::DecorationMatrixStride);
+}
+
+// same tree as get_array_elements() in ShaderReflection.cpp: an Array per
+// dimension, outermost first; path holds the array's name and is restored
+// on return
+template <typename Node, typename Namer>
+void get_array_elements(const Scanner& scan, uint32_t type_id, VarType elem_type, uint32_t elem_size,
+	                    bool compact_arrays, Node& v_array, std::string& path, const Namer& namer)
+{
+	auto& array = fields(v_array);
+	array.array_size = scan.ArrayLength(type_id);
+
+	const uint32_t inner = scan.GetType(type_id)->a;
+	const bool nested = scan.IsArray(inner);
+
+	const size_t name_len = path.size();
+	for (uint32_t i = 0, n = compact_arrays ? std::min(array.array_size, 1u) : array.array_size; i < n; ++i)
+	{
+		path.resize(name_len);
+		append_index(path, i);
+
+		Node unif;
+		namer(unif, path);
+		auto& elem = fields(unif);
+		elem.offset = array.offset + i * array.array_stride;
+		elem.matrix_stride = array.matrix_stride;
+		if (nested)
+		{
+			elem.type = VarType::Array;
+			elem.array_stride = scan.GetArrayStride(inner);
+			elem.size = elem.array_stride * scan.ArrayLength(inner);
+			get_array_elements(scan, inner, elem_type, elem_size, compact_arrays, unif, path, namer);
+		}
+		else
+		{
+			elem.type = elem_type;
+			elem.size = elem_size;
+		}
+
+		v_array.children.push_back(std::move(unif));
+	}
+
+	path.resize(name_len);
+}
+
+// same tree as get_struct_uniforms() in ShaderReflection.cpp, path holds
+// the base name and is restored on return
+template <typename Node, typename Namer>
+void get_struct_uniforms(const Scanner& scan, uint32_t base_type_id, uint32_t type_id,
+	                     std::vector<Node>& uniforms, std::string& path, uint32_t base_offset,
+	                     bool compact_arrays, const Namer& namer)
+{
+	const uint32_t struct_id = scan.StripArrays(type_id);
+	auto struct_type = scan.GetType(struct_id);
+	if (!struct_type || struct_type->op != spv::OpTypeStruct) {
+		return;
+	}
+
+	const uint32_t* members = scan.member_types.data() + struct_type->first_member;
+	const uint32_t member_count = struct_type->member_count;
+
+	const size_t base_len = path.size();
+
+	if (scan.IsArray(type_id))
+	{
+		// outermost dimension, an array of arrays recurses with the element
+		// type; member names come from the innermost element, the struct
+		const uint32_t parent_type = scan.GetType(type_id)->a;
+		const bool nested = scan.IsArray(parent_type);
+		const uint32_t elem_size = nested ? 0 : scan.GetStructSize(parent_type);
+		const uint32_t length = scan.ArrayLength(type_id);
+
+		Node v_array;
+		namer(v_array, path);
+		auto& array = fields(v_array);
+		array.type = VarType::Array;
+		array.offset = base_offset;
+		array.array_stride = scan.GetArrayStride(base_type_id);
+		array.size = array.array_stride * length;
+		array.array_size = length;
+
+		for (uint32_t i = 0, n = compact_arrays ? std::min(length, 1u) : length; i < n; ++i)
+		{
+			const uint32_t elem_offset = base_offset + i * array.array_stride;
+			if (nested)
+			{
+				path.resize(base_len);
+				append_index(path, i);
+				get_struct_uniforms(scan, parent_type, parent_type, v_array.children, path, elem_offset, compact_arrays, namer);
+				continue;
+			}
+
+			Node v_struct;
+			namer(v_struct, std::string_view(path.data(), base_len));
+			auto& str = fields(v_struct);
+			str.type = VarType::Struct;
+			str.offset = elem_offset;
+			str.size = elem_size;
+
+			for (uint32_t j = 0; j < member_count; j++)
+			{
+				path.resize(base_len);
+				append_index(path, i);
+				path.push_back('.');
+				scan.AppendMemberName(parent_type, j, path);
+
+				if (scan.GetBaseType(members[j]).kind == BaseType::Struct)
+				{
+					const uint32_t member_offset = str.offset
+						+ scan.GetMemberDecoration(parent_type, j, spv::DecorationOffset);
+					get_struct_uniforms(scan, members[j], members[j], v_struct.children, path, member_offset, compact_arrays, namer);
+				}
+				else
+				{
+					Node unif;
+					namer(unif, path);
+					fields(unif).type = parse_type(scan, members[j]);
+
+					set_member_layout(scan, parent_type, j, str.offset, unif);
+
+					v_struct.children.push_back(std::move(unif));
+				}
+			}
+
+			v_array.children.push_back(std::move(v_struct));
+		}
+
+		uniforms.push_back(std::move(v_array));
+	}
+	else
+	{
+		Node v_struct;
+		namer(v_struct, path);
+		auto& str = fields(v_struct);
+		str.type = VarType::Struct;
+		str.offset = base_offset;
+		str.size = scan.GetStructSize(struct_id);
+
+		for (uint32_t i = 0; i < member_count; i++)
+		{
+			path.resize(base_len);
+			if (base_len != 0) {
+				path.push_back('.');
+			}
+			scan.AppendMemberName(base_type_id, i, path);
+
+			if (scan.GetBaseType(members[i]).kind == BaseType::Struct)
+			{
+				const uint32_t member_offset = base_offset
+					+ scan.GetMemberDecoration(base_type_id, i, spv::DecorationOffset);
+				get_struct_uniforms(scan, members[i], members[i], v_struct.children, path, member_offset, compact_arrays, namer);
+			}
+			else if (scan.IsArray(members[i]))
+			{
+				Node v_array;
+				namer(v_array, path);
+				auto& array = fields(v_array);
+				array.type = VarType::Array;
+				set_member_layout(scan, struct_id, i, base_offset, v_array);
+
+				const uint32_t elem_size = scan.GetBasicSize(members[i], array.matrix_stride,
+					scan.HasMemberDecoration(struct_id, i, spv::DecorationRowMajor));
+
+				get_array_elements(scan, members[i], parse_type(scan, members[i]), elem_size,
+					compact_arrays, v_array, path, namer);
+
+				v_struct.children.push_back(std::move(v_array));
+			}
+			else
+			{
+				Node unif;
+				namer(unif, path);
+				fields(unif).type = parse_type(scan, members[i]);
+
+				set_member_layout(scan, struct_id, i, base_offset, unif);
+
+				v_struct.children.push_back(std::move(unif));
+			}
+		}
+
+		// an unnamed block adds its members as roots
+		if (base_len == 0) {
+			std::move(v_struct.children.begin(), v_struct.children.end(), std::back_inserter(uniforms));
+		} else {
+			uniforms.push_back(std::move(v_struct));
+		}
+	}
+
+	path.resize(base_len);
+}
+
+template <typename Node>
+void set_binding(Node& node, uint32_t binding)
+{
+	fields(node).binding = binding;
+	for (auto& child : node.children) {
+		set_binding(child, binding);
+	}
+}
+
+template <typename Node, typename Namer>
+void get_uniforms(const Scanner& scan, std::vector<Node>& uniforms, bool compact_arrays, const Namer& namer)
+{
+	std::vector<const GlobalVar*> ssbos, ubos, sampled_images, storage_images;
+	for (auto& var : scan.variables)
+	{
+		auto ptr = scan.GetType(var.type);
+		if (!ptr || ptr->op != spv::OpTypePointer) {
+			continue;
+		}
+
+		const uint32_t storage = ptr->a;
+		const uint32_t self = scan.StripArrays(ptr->b);
+		const uint32_t flags = scan.GetFlags(self);
+		auto base = scan.GetBaseType(self);
+
+		// same classification and precedence as Compiler::get_shader_resources()
+		if (storage == spv::StorageClassUniformConstant && base.kind == BaseType::Image
+		 && scan.GetType(self)->b == spv::DimSubpassData) {
+			continue;
+		} else if (storage == spv::StorageClassUniform && (flags & FLAG_BLOCK)) {
+			ubos.push_back(&var);
+		} else if (storage == spv::StorageClassUniform && (flags & FLAG_BUFFER_BLOCK)) {
+			ssbos.push_back(&var);
+		} else if (storage == spv::StorageClassStorageBuffer) {
+			ssbos.push_back(&var);
+		} else if (storage == spv::StorageClassUniformConstant && base.kind == BaseType::Image
+		        && scan.GetType(self)->c == 2) {
+			storage_images.push_back(&var);
+		} else if (storage == spv::StorageClassUniformConstant && base.kind == BaseType::SampledImage) {
+			sampled_images.push_back(&var);
+		}
+	}
+
+	std::string path;
+
+	// ssbo
+	for (auto var : ssbos)
+	{
+		const uint32_t self = scan.StripArrays(scan.GetType(var->type)->b);
+
+		// the declared block name, with SPIRV-Cross's fallbacks
+		path.clear();
+		scan.AppendName(self, path);
+		if (path.empty()) {
+			scan.AppendName(var->id, path);
+		}
+		if (path.empty()) {
+			path = "_" + std::to_string(self) + "_" + std::to_string(var->id);
+		}
+
+		Node v;
+		namer(v, path);
+		auto& buf = fields(v);
+		buf.type = VarType::StorageBuffer;
+		buf.binding = scan.GetBinding(var->id);
+		buf.size = scan.GetStructSize(self);
+
+		uniforms.push_back(std::move(v));
+	}
+
+	// uniforms
+	for (auto var : ubos)
+	{
+		const uint32_t self = scan.StripArrays(scan.GetType(var->type)->b);
+		const size_t first = uniforms.size();
+		if (scan.GetBaseType(self).kind == BaseType::Struct)
+		{
+			path.clear();
+			scan.AppendName(var->id, path);
+			get_struct_uniforms(scan, self, self, uniforms, path, 0, compact_arrays, namer);
+		}
+
+		for (size_t i = first; i < uniforms.size(); ++i) {
+			set_binding(uniforms[i], scan.GetBinding(var->id));
+		}
+	}
+
+	int idx = 0;
+	for (auto var : sampled_images)
+	{
+		path.clear();
+		scan.AppendName(var->id, path);
+		if (shadertrans::ShaderRename::IsTemporaryName(path)) {
+			path = "texture" + std::to_string(idx);
+		}
+
+		Node unif;
+		namer(unif, path);
+		fields(unif).type = VarType::Sampler;
+		fields(unif).binding = scan.GetBinding(var->id);
+
+		uniforms.push_back(std::move(unif));
+
+		++idx;
+	}
+
+	for (auto var : storage_images)
+	{
+		path.clear();
+		scan.AppendName(var->id, path);
+
+		Node unif;
+		namer(unif, path);
+		fields(unif).type = VarType::Image;
+		fields(unif).binding = scan.GetBinding(var->id);
+
+		uniforms.push_back(std::move(unif));
+	}
+}
+
+// same mapping as parser_spvgentwo_variable() in ShaderReflection.cpp
+VarType parse_func_type(const Scanner& scan, uint32_t type_id)
+{
+	auto type = scan.GetType(type_id);
+	if (type && type->op == spv::OpTypePointer) {
+		type = scan.GetType(type->b);
+	}
+	if (!type) {
+		return VarType::Unknown;
+	}
+
+	auto vec_type = [](VarType vec2, uint32_t count) {
+		return count >= 2 && count <= 4 ? static_cast<VarType>(static_cast<int>(vec2) + count - 2) : VarType::Unknown;
+	};
+
+	switch (type->op)
+	{
+	case spv::OpTypeVoid:
+		return VarType::Void;
+	case spv::OpTypeBool:
+		return VarType::Bool;
+	case spv::OpTypeInt:
+		return VarType::Int;
+	case spv::OpTypeFloat:
+		return VarType::Float;
+	case spv::OpTypeMatrix:
+		return vec_type(VarType::Mat2, type->b);
+	case spv::OpTypeVector:
+		if (auto comp = scan.GetType(type->a))
+		{
+			if (comp->op == spv::OpTypeInt) {
+				return vec_type(VarType::Int2, type->b);
+			} else if (comp->op == spv::OpTypeFloat) {
+				return vec_type(VarType::Float2, type->b);
+			}
+		}
+		break;
+	case spv::OpTypeArray:
+		return VarType::Array;
+	case spv::OpTypeStruct:
+		return VarType::Struct;
+	case spv::OpTypeSampledImage:
+		return VarType::Sampler;
+	default:
+		break;
+	}
+	return VarType::Unknown;
+}
+
+// the name GetFunction() matches against, "src.foo(vf4;" is "foo"
+std::string short_func_name(std::string name)
+{
+	auto itr_dot = name.find('.');
+	if (itr_dot != std::string::npos) {
+		name = name.substr(itr_dot + 1);
+	}
+	return name.substr(0, name.find_first_of('('));
+}
+
+void get_function(const Scanner& scan, const Func& f, shadertrans::ShaderReflection::Function& func)
+{
+	func.ret_type.type = parse_func_type(scan, f.ret_type);
+	for (uint32_t i = 0; i < f.param_count; ++i)
+	{
+		auto& param = scan.params[f.first_param + i];
+
+		Variable arg;
+		arg.name = scan.Name(param.id);
+		arg.type = parse_func_type(scan, param.type);
+
+		func.arguments.push_back(arg);
+	}
+}
+
+}
+
+namespace shadertrans
+{
+namespace spirv
+{
+
+void Reflection::GetUniforms(SpirvSpan spirv, std::vector<ShaderReflection::Variable>& uniforms,
+                             bool compact_arrays)
+{
+	Scanner scan;
+	if (!scan.Scan(spirv, false)) {
+		return;
+	}
+
+	get_uniforms(scan, uniforms, compact_arrays, [](Variable& var, std::string_view path) {
+		var.name = std::string(path);
+	});
+}
+
+void Reflection::GetUniforms(SpirvSpan spirv, ReflectionContext& ctx, ReflectionContext::UniformTable& table,
+                             bool compact_arrays)
+{
+	table.variables.clear();
+	table.root_count = 0;
+
+	Scanner scan;
+	if (!scan.Scan(spirv, false)) {
+		return;
+	}
+
+	std::vector<HandleNode> uniforms;
+	get_uniforms(scan, uniforms, compact_arrays, [&ctx](HandleNode& node, std::string_view path) {
+		node.var.name = ctx.Intern(path);
+	});
+
+	// breadth first, same layout as ReflectionContext::Flatten()
+	table.root_count = static_cast<uint32_t>(uniforms.size());
+
+	std::vector<const HandleNode*> src;
+	for (auto& node : uniforms) {
+		src.push_back(&node);
+	}
+	table.variables.resize(src.size());
+
+	for (size_t i = 0; i < src.size(); ++i)
+	{
+		auto& from = *src[i];
+
+		auto to = from.var;
+		to.parent = table.variables[i].parent;
+		to.first_child = static_cast<uint32_t>(src.size());
+		to.child_count = static_cast<uint32_t>(from.children.size());
+		for (auto& child : from.children)
+		{
+			src.push_back(&child);
+
+			ReflectionContext::Variable v;
+			v.parent = static_cast<uint32_t>(i);
+			table.variables.push_back(v);
+		}
+
+		table.variables[i] = to;
+	}
+}
+
+bool Reflection::GetFunction(SpirvSpan spirv, const std::string& name, ShaderReflection::Function& func)
+{
+	Scanner scan;
+	if (!scan.Scan(spirv, true)) {
+		return false;
+	}
+
+	for (auto& f : scan.funcs)
+	{
+		if (short_func_name(scan.Name(f.id)) == name) {
+			get_function(scan, f, func);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool Reflection::GetFunctions(SpirvSpan spirv,
+	                          std::vector<std::pair<std::string, ShaderReflection::Function>>& funcs)
+{
+	Scanner scan;
+	if (!scan.Scan(spirv, true)) {
+		return false;
+	}
+
+	funcs.reserve(funcs.size() + scan.funcs.size());
+	for (auto& f : scan.funcs)
+	{
+		funcs.emplace_back(short_func_name(scan.Name(f.id)), ShaderReflection::Function());
+		get_function(scan, f, funcs.back().second);
+	}
+
+	return true;
+}
+
+}
+}
\ No newline at end of file
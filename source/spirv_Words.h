@@ -0,0 +1,166 @@
+#pragma once
+
+// Word level helpers shared by spirv::Parser and spirv::Reflection, internal
+// to the library.
+
+#include "shadertrans/SpirvSpan.h"
+
+#include <spirv/unified1/spirv.hpp>
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#include <stdint.h>
+
+namespace shadertrans
+{
+namespace spirv
+{
+
+// fewest words an instruction the Parser or the Reflection scanner decodes
+// can have, 0 for the ones they only count or skip; shorter ones are
+// malformed and never handed out by WordScanner
+inline uint32_t MinWordCount(uint32_t op)
+{
+	switch (op)
+	{
+	case spv::OpFunctionEnd:
+		return 1;
+	case spv::OpTypeVoid:
+	case spv::OpTypeBool:
+	case spv::OpTypeSampler:
+	case spv::OpTypeStruct:
+		return 2;
+	case spv::OpName:
+	case spv::OpDecorate:
+	case spv::OpExecutionMode:
+	case spv::OpTypeFloat:
+	case spv::OpTypeRuntimeArray:
+	case spv::OpTypeSampledImage:
+	case spv::OpFunctionParameter:
+		return 3;
+	case spv::OpLine:
+	case spv::OpMemberName:
+	case spv::OpMemberDecorate:
+	case spv::OpConstant:
+	case spv::OpTypeInt:
+	case spv::OpTypeVector:
+	case spv::OpTypeMatrix:
+	case spv::OpTypeArray:
+	case spv::OpTypePointer:
+	case spv::OpVariable:
+		return 4;
+	case spv::OpFunction:
+		return 5;
+	case spv::OpTypeImage:
+		return 9;
+	default:
+		return 0;
+	}
+}
+
+struct Instruction
+{
+	uint32_t op = 0;
+	uint32_t word_count = 0;
+
+	// words[0] is the opcode word, at offset in the module
+	const unsigned int* words = nullptr;
+	size_t offset = 0;
+};
+
+// Walks the instructions after the header. Stops at a zero word count or at
+// an instruction running past the end, skips the ones shorter than
+// MinWordCount().
+class WordScanner
+{
+public:
+	WordScanner(SpirvSpan spv)
+		: m_spv(spv), m_pos(std::min<size_t>(5, spv.size())) {}
+
+	bool Next(Instruction& inst)
+	{
+		const size_t n = m_spv.size();
+		while (m_pos < n)
+		{
+			const uint32_t word_count = m_spv[m_pos] >> spv::WordCountShift;
+			const uint32_t op = m_spv[m_pos] & spv::OpCodeMask;
+			if (word_count == 0 || m_pos + word_count > n) {
+				break;
+			}
+
+			const size_t offset = m_pos;
+			m_pos += word_count;
+			if (word_count < MinWordCount(op)) {
+				continue;
+			}
+
+			inst.op = op;
+			inst.word_count = word_count;
+			inst.words = m_spv.data() + offset;
+			inst.offset = offset;
+			return true;
+		}
+
+		m_pos = n;
+		return false;
+	}
+
+	// the next Next() returns false
+	void Stop() { m_pos = m_spv.size(); }
+
+private:
+	SpirvSpan m_spv;
+	size_t m_pos;
+
+}; // WordScanner
+
+// Per-id records. Ids are usually dense and below the header's bound, but
+// the bound is only an upper limit: the flat table stops at the module's
+// word count and sparse ids past that go to the overflow map. Ids at or
+// above the bound are invalid, Get() hands out a scratch record for them.
+template <typename T>
+class IdTable
+{
+public:
+	void Reset(SpirvSpan spv)
+	{
+		m_bound = spv.size() >= 5 ? spv[3] : 0;
+		m_flat.assign(std::min<size_t>(m_bound, spv.size()), T());
+		m_overflow.clear();
+	}
+
+	T& Get(uint32_t id)
+	{
+		if (id < m_flat.size()) {
+			return m_flat[id];
+		}
+		if (id < m_bound) {
+			return m_overflow[id];
+		}
+		m_scratch = T();
+		return m_scratch;
+	}
+
+	const T* Find(uint32_t id) const
+	{
+		if (id < m_flat.size()) {
+			return &m_flat[id];
+		}
+		auto itr = m_overflow.find(id);
+		return itr != m_overflow.end() ? &itr->second : nullptr;
+	}
+
+private:
+	uint32_t m_bound = 0;
+
+	std::vector<T> m_flat;
+	std::unordered_map<uint32_t, T> m_overflow;
+
+	T m_scratch;
+
+}; // IdTable
+
+}
+}
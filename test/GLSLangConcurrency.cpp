@@ -0,0 +1,139 @@
+// GLSL2SpirV, ShaderParser::ParseHLSL and ShaderValidator::Validate from
+// many threads at once, see the guarantee in GLSLangAdapter.h
+
+#include "shadertrans/ShaderTrans.h"
+#include "shadertrans/ShaderParser.h"
+#include "shadertrans/ShaderValidator.h"
+#include "shadertrans/GLSLangAdapter.h"
+
+#include <glslang/public/ShaderLang.h>
+
+#include <atomic>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <iostream>
+
+namespace
+{
+
+const char* GLSL_SPIRV = R"(
+#version 450
+layout(location = 0) in vec2 v_uv;
+layout(location = 0) out vec4 frag_color;
+layout(binding = 0) uniform sampler2D u_tex;
+void main()
+{
+	frag_color = texture(u_tex, v_uv);
+}
+)";
+
+const char* GLSL_VALIDATE = R"(
+#version 330
+out vec4 frag_color;
+void main()
+{
+	frag_color = vec4(1.0);
+}
+)";
+
+const char* HLSL = R"(
+float4 main(float4 pos : SV_Position) : SV_Target
+{
+	return pos * 0.5;
+}
+)";
+
+const int THREAD_NUM = 16;
+const int ITERATIONS = 32;
+
+}
+
+int main()
+{
+	using namespace shadertrans;
+
+	// shared by every thread, plus one per thread so that ShInitialize()
+	// and ShFinalize() reference counting is exercised too
+	ShaderValidator shared_validator(ShaderStage::PixelShader);
+
+	std::atomic<int> failures = 0;
+	std::atomic<bool> start = false;
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < THREAD_NUM; ++t)
+	{
+		threads.emplace_back([&, t]()
+		{
+			while (!start) {
+				std::this_thread::yield();
+			}
+
+			auto own_validator = std::make_unique<ShaderValidator>(ShaderStage::PixelShader);
+			for (int i = 0; i < ITERATIONS; ++i)
+			{
+				std::ostringstream out;
+				switch ((t + i) % 4)
+				{
+				case 0:
+				{
+					std::vector<unsigned int> spirv;
+					ShaderTrans::GLSL2SpirV(ShaderStage::PixelShader, GLSL_SPIRV, nullptr, spirv, false, out);
+					if (spirv.empty()) {
+						++failures;
+						std::cerr << "GLSL2SpirV failed:\n" << out.str();
+					}
+					break;
+				}
+				case 1:
+				{
+					std::unique_ptr<glslang::TShader> shader(ShaderParser::ParseHLSL(HLSL));
+					if (!shader) {
+						++failures;
+						std::cerr << "ParseHLSL failed\n";
+					}
+					break;
+				}
+				case 2:
+					if (!shared_validator.Validate(GLSL_VALIDATE, true, out)) {
+						++failures;
+						std::cerr << "shared Validate failed:\n" << out.str();
+					}
+					break;
+				case 3:
+					if (!own_validator->Validate(GLSL_VALIDATE, true, out)) {
+						++failures;
+						std::cerr << "Validate failed:\n" << out.str();
+					}
+					break;
+				}
+			}
+		});
+	}
+
+	start = true;
+	for (auto& t : threads) {
+		t.join();
+	}
+
+	if (!GLSLangAdapter::Instance()->IsInited()) {
+		++failures;
+		std::cerr << "glslang isn't initialized after the compiles\n";
+	}
+
+	// init again after finalize
+	GLSLangAdapter::Instance()->Finalize();
+	std::vector<unsigned int> spirv;
+	ShaderTrans::GLSL2SpirV(ShaderStage::PixelShader, GLSL_SPIRV, nullptr, spirv);
+	if (spirv.empty()) {
+		++failures;
+		std::cerr << "GLSL2SpirV failed after Finalize()\n";
+	}
+
+	if (failures > 0) {
+		std::cerr << failures << " failures\n";
+		return 1;
+	}
+	return 0;
+}
\ No newline at end of file
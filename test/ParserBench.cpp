@@ -0,0 +1,587 @@
+// Parses a large generated SPIR-V module many times with spirv::Parser and
+// with the parse loop it replaced, which kept the per-id names, pointers and
+// types in unordered_maps and resolved types through a std::function.
+// Both must produce the same module.
+
+#include "shadertrans/spirv_Parser.h"
+
+#include <spirv/unified1/spirv.hpp>
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace shadertrans
+{
+namespace spirv
+{
+std::string spvReadString(const unsigned int* data, int length, int& i);
+}
+}
+
+namespace
+{
+
+using namespace shadertrans::spirv;
+
+typedef unsigned int spv_word;
+
+const int STRUCT_NUM   = 256;
+const int FUNCTION_NUM = 4096;
+const int ITERATIONS   = 50;
+
+class ModuleWriter
+{
+public:
+	ModuleWriter() {
+		m_words = { spv::MagicNumber, 0x00010000, 0, 0, 0 };
+	}
+
+	spv_word NewId() { return m_next_id++; }
+
+	void Op(spv::Op op, std::initializer_list<spv_word> operands) {
+		m_words.push_back(((spv_word)(operands.size() + 1) << spv::WordCountShift) | op);
+		m_words.insert(m_words.end(), operands.begin(), operands.end());
+	}
+	void OpWithString(spv::Op op, std::initializer_list<spv_word> operands, const std::string& str) {
+		const size_t str_words = str.size() / 4 + 1;
+		m_words.push_back(((spv_word)(operands.size() + str_words + 1) << spv::WordCountShift) | op);
+		m_words.insert(m_words.end(), operands.begin(), operands.end());
+		for (size_t i = 0; i < str_words; ++i)
+		{
+			spv_word w = 0;
+			for (size_t j = 0; j < 4 && i * 4 + j < str.size(); ++j) {
+				w |= (spv_word)(unsigned char)str[i * 4 + j] << (j * 8);
+			}
+			m_words.push_back(w);
+		}
+	}
+
+	std::vector<spv_word> Finish() {
+		m_words[3] = m_next_id;
+		return m_words;
+	}
+
+private:
+	std::vector<spv_word> m_words;
+	spv_word m_next_id = 1;
+
+}; // ModuleWriter
+
+// uniform blocks of structs, a few unnamed, private globals and functions
+// with arguments, locals, lines and arithmetic, as glslang emits them
+std::vector<spv_word> build_module()
+{
+	ModuleWriter w;
+
+	const spv_word t_void = w.NewId(), t_float = w.NewId(), t_int = w.NewId(),
+		t_vec4 = w.NewId(), t_mat4 = w.NewId(), t_func = w.NewId(),
+		t_ptr_func_float = w.NewId(), t_ptr_func_vec4 = w.NewId(), t_ptr_private_vec4 = w.NewId();
+
+	w.Op(spv::OpExecutionMode, { 1, spv::ExecutionModeLocalSize, 8, 8, 1 });
+
+	w.Op(spv::OpTypeVoid, { t_void });
+	w.Op(spv::OpTypeFloat, { t_float, 32 });
+	w.Op(spv::OpTypeInt, { t_int, 32, 1 });
+	w.Op(spv::OpTypeVector, { t_vec4, t_float, 4 });
+	w.Op(spv::OpTypeMatrix, { t_mat4, t_vec4, 4 });
+	w.Op(spv::OpTypeFunction, { t_func, t_vec4, t_ptr_func_vec4, t_ptr_func_float });
+	w.Op(spv::OpTypePointer, { t_ptr_func_float, spv::StorageClassFunction, t_float });
+	w.Op(spv::OpTypePointer, { t_ptr_func_vec4, spv::StorageClassFunction, t_vec4 });
+	w.Op(spv::OpTypePointer, { t_ptr_private_vec4, spv::StorageClassPrivate, t_vec4 });
+
+	for (int i = 0; i < STRUCT_NUM; ++i)
+	{
+		const spv_word t_struct = w.NewId(), t_ptr = w.NewId(), var = w.NewId();
+		const std::string name = "Block" + std::to_string(i);
+		w.OpWithString(spv::OpName, { t_struct }, name);
+		w.OpWithString(spv::OpMemberName, { t_struct, 0 }, "scale");
+		w.OpWithString(spv::OpMemberName, { t_struct, 1 }, "color");
+		w.OpWithString(spv::OpMemberName, { t_struct, 2 }, "model");
+		w.OpWithString(spv::OpMemberName, { t_struct, 3 }, "count");
+		w.Op(spv::OpTypeStruct, { t_struct, t_float, t_vec4, t_mat4, t_int });
+		w.Op(spv::OpTypePointer, { t_ptr, spv::StorageClassUniform, t_struct });
+		w.OpWithString(spv::OpName, { var }, i % 4 == 0 ? "" : "u_" + name);
+		w.Op(spv::OpVariable, { t_ptr, var, spv::StorageClassUniform });
+
+		const spv_word global = w.NewId();
+		w.OpWithString(spv::OpName, { global }, "g_" + std::to_string(i));
+		w.Op(spv::OpVariable, { t_ptr_private_vec4, global, spv::StorageClassPrivate });
+	}
+
+	for (int i = 0; i < FUNCTION_NUM; ++i)
+	{
+		const spv_word func = w.NewId(), arg0 = w.NewId(), arg1 = w.NewId();
+		w.OpWithString(spv::OpName, { func }, "func" + std::to_string(i) + "(vf4;f1;");
+		w.OpWithString(spv::OpName, { arg0 }, "pos");
+		w.OpWithString(spv::OpName, { arg1 }, "scale");
+
+		w.Op(spv::OpFunction, { t_vec4, func, 0, t_func });
+		w.Op(spv::OpFunctionParameter, { t_ptr_func_vec4, arg0 });
+		w.Op(spv::OpFunctionParameter, { t_ptr_func_float, arg1 });
+		w.Op(spv::OpLabel, { w.NewId() });
+		w.Op(spv::OpLine, { 1, spv_word(i * 10 + 1), 0 });
+
+		spv_word locals[4];
+		for (int j = 0; j < 4; ++j)
+		{
+			locals[j] = w.NewId();
+			w.OpWithString(spv::OpName, { locals[j] }, "tmp" + std::to_string(j));
+			w.Op(spv::OpVariable, { j % 2 ? t_ptr_func_float : t_ptr_func_vec4, locals[j], spv::StorageClassFunction });
+		}
+
+		spv_word last = arg0;
+		for (int j = 0; j < 16; ++j)
+		{
+			const spv_word val = w.NewId();
+			w.Op(spv::OpLine, { 1, spv_word(i * 10 + 2 + j / 4), 0 });
+			w.Op(j % 3 ? spv::OpFMul : spv::OpFAdd, { t_vec4, val, last, locals[j % 4] });
+			last = val;
+		}
+		w.Op(spv::OpReturnValue, { last });
+		w.Op(spv::OpFunctionEnd, {});
+	}
+
+	return w.Finish();
+}
+
+// the parse loop before the flat id tables
+void parse_legacy(const std::vector<unsigned int>& ir, Module& module)
+{
+	module.functions.clear();
+	module.user_types.clear();
+	module.uniforms.clear();
+	module.globals.clear();
+
+	module.arithmetic_inst_count = 0;
+	module.bit_inst_count = 0;
+	module.logical_inst_count = 0;
+	module.texture_inst_count = 0;
+	module.derivative_inst_count = 0;
+	module.control_flow_inst_count = 0;
+
+	module.barrier_used = false;
+	module.local_size_x = 1;
+	module.local_size_y = 1;
+	module.local_size_z = 1;
+
+	std::string curFunc = "";
+	int lastOpLine = -1;
+
+	std::unordered_map<spv_word, std::string> names;
+	std::unordered_map<spv_word, spv_word> pointers;
+	std::unordered_map<spv_word, std::pair<ValueType, int>> types;
+
+	std::function<void(Variable&, spv_word)> fetchType = [&](Variable& var, spv_word type) {
+		spv_word actualType = type;
+		if (pointers.count(type))
+			actualType = pointers[type];
+
+		const std::pair<ValueType, int>& info = types[actualType];
+		var.type = info.first;
+		var.base_type = var.type;
+			
+		if (var.type == ValueType::Struct)
+		{
+			var.type_name = names[info.second];
+		}
+		else if (var.type == ValueType::Vector) 
+		{
+			var.type_comp_count = info.second & 0x00ffffff;
+			var.base_type = (ValueType)((info.second & 0xff000000) >> 24);
+		} 
+		else if (var.type == ValueType::Matrix)
+		{
+			var.type_comp_count = info.second & 0x00ffffff;
+			var.base_type = ValueType::Matrix;
+		}
+	};
+
+	for (int i = 5; i < ir.size();) {
+		int iStart = i;
+		spv_word opcodeData = ir[i];
+
+		spv_word wordCount = ((opcodeData & (~spv::OpCodeMask)) >> spv::WordCountShift) - 1;
+		spv_word opcode = (opcodeData & spv::OpCodeMask);
+
+		switch (opcode) {
+		case spv::OpName: {
+			spv_word loc = ir[++i];
+			spv_word stringLength = wordCount - 1;
+
+			names[loc] = spvReadString(ir.data(), stringLength, ++i);
+		} break;
+		case spv::OpLine: {
+			++i; // skip file
+			lastOpLine = ir[++i];
+
+			if (!curFunc.empty() && module.functions[curFunc].line_start == -1)
+				module.functions[curFunc].line_start = lastOpLine;
+		} break;
+		case spv::OpTypeStruct: {
+			spv_word loc = ir[++i];
+
+			spv_word memCount = wordCount - 1;
+			if (module.user_types.count(names[loc]) == 0) {
+				std::vector<Variable> mems(memCount);
+				for (spv_word j = 0; j < memCount; j++) {
+					spv_word type = ir[++i];
+					fetchType(mems[j], type);
+				}
+
+				module.user_types.insert(std::make_pair(names[loc], mems));
+			} else {
+				auto& typeInfo = module.user_types[names[loc]];
+				for (spv_word j = 0; j < memCount && j < typeInfo.size(); j++) {
+					spv_word type = ir[++i];
+					fetchType(typeInfo[j], type);
+				}
+			}
+
+			types[loc] = std::make_pair(ValueType::Struct, loc);
+		} break;
+		case spv::OpMemberName: {
+			spv_word owner = ir[++i];
+			spv_word index = ir[++i]; // index
+
+			spv_word stringLength = wordCount - 2;
+
+			auto& typeInfo = module.user_types[names[owner]];
+
+			if (index < typeInfo.size())
+				typeInfo[index].name = spvReadString(ir.data(), stringLength, ++i);
+			else {
+				typeInfo.resize(index + 1);
+				typeInfo[index].name = spvReadString(ir.data(), stringLength, ++i);
+			}
+		} break;
+		case spv::OpFunction: {
+			spv_word type = ir[++i];
+			spv_word loc = ir[++i];
+
+			curFunc = names[loc];
+			size_t dot = curFunc.find_first_of('.');
+			if (dot != std::string::npos) {
+				curFunc = curFunc.substr(dot + 1);
+			}
+			size_t args = curFunc.find_first_of('(');
+			if (args != std::string::npos) {
+				curFunc = curFunc.substr(0, args);
+			}
+
+			fetchType(module.functions[curFunc].ret_type, type);
+			module.functions[curFunc].line_start = -1;
+			module.functions[curFunc].index = module.functions.size() - 1;
+		} break;
+		case spv::OpFunctionEnd: {
+			module.functions[curFunc].line_end = lastOpLine;
+			lastOpLine = -1;
+			curFunc = "";
+		} break;
+		case spv::OpVariable: {
+			spv_word type = ir[++i];
+			spv_word loc = ir[++i];
+
+			std::string varName = names[loc];
+
+			if (curFunc.empty()) {
+				spv::StorageClass sType = (spv::StorageClass)ir[++i];
+				if (sType == spv::StorageClassUniform || sType == spv::StorageClassUniformConstant) {
+					Variable uni;
+					uni.name = varName;
+					fetchType(uni, type);
+
+					if (uni.name.size() == 0 || uni.name[0] == 0) {
+						if (module.user_types.count(uni.type_name) > 0) {
+							const std::vector<Variable>& mems = module.user_types[uni.type_name];
+							for (const auto& mem : mems)
+								module.uniforms.push_back(mem);
+						}
+					} else
+						module.uniforms.push_back(uni);
+				} else if (varName.size() > 0 && varName[0] != 0) {
+					Variable glob;
+					glob.name = varName;
+					fetchType(glob, type);
+
+					module.globals.push_back(glob);
+				}
+			} else {
+				Variable loc;
+				loc.name = varName;
+				fetchType(loc, type);
+				module.functions[curFunc].locals.push_back(loc);
+			}
+		} break;
+		case spv::OpFunctionParameter: {
+			spv_word type = ir[++i];
+			spv_word loc = ir[++i];
+
+			Variable arg;
+			arg.name = names[loc];
+			fetchType(arg, type);
+			module.functions[curFunc].arguments.push_back(arg);
+		} break;
+		case spv::OpTypePointer: {
+			spv_word loc = ir[++i];
+			++i; // skip storage class
+			spv_word type = ir[++i];
+
+			pointers[loc] = type;
+		} break;
+		case spv::OpTypeBool: {
+			spv_word loc = ir[++i];
+			types[loc] = std::make_pair(ValueType::Bool, 0);
+		} break;
+		case spv::OpTypeInt: {
+			spv_word loc = ir[++i];
+			types[loc] = std::make_pair(ValueType::Int, 0);
+		} break;
+		case spv::OpTypeFloat: {
+			spv_word loc = ir[++i];
+			types[loc] = std::make_pair(ValueType::Float, 0);
+		} break;
+		case spv::OpTypeVector: {
+			spv_word loc = ir[++i];
+			spv_word comp = ir[++i];
+			spv_word compcount = ir[++i];
+
+			spv_word val = (compcount & 0x00FFFFFF) | (((spv_word)types[comp].first) << 24);
+
+			types[loc] = std::make_pair(ValueType::Vector, val);
+		} break;
+		case spv::OpTypeMatrix: {
+			spv_word loc = ir[++i];
+			spv_word comp = ir[++i];
+			spv_word compcount = ir[++i];
+
+			spv_word val = (compcount & 0x00FFFFFF) | (types[comp].second & 0xFF000000);
+
+			types[loc] = std::make_pair(ValueType::Matrix, val);
+		} break;
+		case spv::OpExecutionMode: {
+			++i; // skip
+			spv_word execMode = ir[++i];
+
+			if (execMode == spv::ExecutionMode::ExecutionModeLocalSize) {
+				module.local_size_x = ir[++i];
+				module.local_size_y = ir[++i];
+				module.local_size_z = ir[++i];
+			}
+		} break;
+
+		case spv::OpControlBarrier:
+		case spv::OpMemoryBarrier:
+		case spv::OpNamedBarrierInitialize: {
+			module.barrier_used = true;
+		} break;
+
+		case spv::OpSNegate: case spv::OpFNegate:
+		case spv::OpIAdd: case spv::OpFAdd:
+		case spv::OpISub: case spv::OpFSub:
+		case spv::OpIMul: case spv::OpFMul:
+		case spv::OpUDiv: case spv::OpSDiv:
+		case spv::OpFDiv: case spv::OpUMod:
+		case spv::OpSRem: case spv::OpSMod:
+		case spv::OpFRem: case spv::OpFMod:
+		case spv::OpVectorTimesScalar:
+		case spv::OpMatrixTimesScalar:
+		case spv::OpVectorTimesMatrix:
+		case spv::OpMatrixTimesVector:
+		case spv::OpMatrixTimesMatrix:
+		case spv::OpOuterProduct:
+		case spv::OpDot:
+		case spv::OpIAddCarry:
+		case spv::OpISubBorrow:
+		case spv::OpUMulExtended:
+		case spv::OpSMulExtended:
+			module.arithmetic_inst_count++;
+			break;
+
+				
+		case spv::OpShiftRightLogical:
+		case spv::OpShiftRightArithmetic:
+		case spv::OpShiftLeftLogical:
+		case spv::OpBitwiseOr:
+		case spv::OpBitwiseXor:
+		case spv::OpBitwiseAnd:
+		case spv::OpNot:
+		case spv::OpBitFieldInsert:
+		case spv::OpBitFieldSExtract:
+		case spv::OpBitFieldUExtract:
+		case spv::OpBitReverse:
+		case spv::OpBitCount:
+			module.bit_inst_count++;
+			break;
+
+		case spv::OpAny: case spv::OpAll:
+		case spv::OpIsNan: case spv::OpIsInf:
+		case spv::OpIsFinite: case spv::OpIsNormal:
+		case spv::OpSignBitSet: case spv::OpLessOrGreater:
+		case spv::OpOrdered: case spv::OpUnordered:
+		case spv::OpLogicalEqual: case spv::OpLogicalNotEqual:
+		case spv::OpLogicalOr: case spv::OpLogicalAnd:
+		case spv::OpLogicalNot: case spv::OpSelect:
+		case spv::OpIEqual: case spv::OpINotEqual:
+		case spv::OpUGreaterThan: case spv::OpSGreaterThan:
+		case spv::OpUGreaterThanEqual: case spv::OpSGreaterThanEqual:
+		case spv::OpULessThan: case spv::OpSLessThan:
+		case spv::OpULessThanEqual: case spv::OpSLessThanEqual:
+		case spv::OpFOrdEqual: case spv::OpFUnordEqual:
+		case spv::OpFOrdNotEqual: case spv::OpFUnordNotEqual:
+		case spv::OpFOrdLessThan: case spv::OpFUnordLessThan:
+		case spv::OpFOrdGreaterThan: case spv::OpFUnordGreaterThan:
+		case spv::OpFOrdLessThanEqual: case spv::OpFUnordLessThanEqual:
+		case spv::OpFOrdGreaterThanEqual: case spv::OpFUnordGreaterThanEqual:
+			module.logical_inst_count++;
+			break;
+
+		case spv::OpImageSampleImplicitLod:
+		case spv::OpImageSampleExplicitLod:
+		case spv::OpImageSampleDrefImplicitLod:
+		case spv::OpImageSampleDrefExplicitLod:
+		case spv::OpImageSampleProjImplicitLod:
+		case spv::OpImageSampleProjExplicitLod:
+		case spv::OpImageSampleProjDrefImplicitLod:
+		case spv::OpImageSampleProjDrefExplicitLod:
+		case spv::OpImageFetch: case spv::OpImageGather:
+		case spv::OpImageDrefGather: case spv::OpImageRead:
+		case spv::OpImageWrite:
+			module.texture_inst_count++;
+			break;
+
+		case spv::OpDPdx:
+		case spv::OpDPdy:
+		case spv::OpFwidth:
+		case spv::OpDPdxFine:
+		case spv::OpDPdyFine:
+		case spv::OpFwidthFine:
+		case spv::OpDPdxCoarse:
+		case spv::OpDPdyCoarse:
+		case spv::OpFwidthCoarse:
+			module.derivative_inst_count++;
+			break;
+
+		case spv::OpPhi:
+		case spv::OpLoopMerge:
+		case spv::OpSelectionMerge:
+		case spv::OpLabel:
+		case spv::OpBranch:
+		case spv::OpBranchConditional:
+		case spv::OpSwitch:
+		case spv::OpKill:
+		case spv::OpReturn:
+		case spv::OpReturnValue:
+			module.control_flow_inst_count++;
+			break;
+		}
+
+		i = iStart + wordCount + 1;
+	}
+}
+
+bool same_var(const Variable& a, const Variable& b)
+{
+	return a.name == b.name && a.type == b.type && a.base_type == b.base_type
+		&& a.type_comp_count == b.type_comp_count && a.type_name == b.type_name;
+}
+
+bool same_vars(const std::vector<Variable>& a, const std::vector<Variable>& b)
+{
+	if (a.size() != b.size()) {
+		return false;
+	}
+	for (size_t i = 0; i < a.size(); ++i) {
+		if (!same_var(a[i], b[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool same_module(const Module& a, const Module& b)
+{
+	if (a.functions.size() != b.functions.size() || a.user_types.size() != b.user_types.size()) {
+		return false;
+	}
+	for (auto& itr : a.functions)
+	{
+		auto find = b.functions.find(itr.first);
+		if (find == b.functions.end()) {
+			return false;
+		}
+		auto& fa = itr.second;
+		auto& fb = find->second;
+		if (fa.line_start != fb.line_start || fa.line_end != fb.line_end
+		 || !same_var(fa.ret_type, fb.ret_type)
+		 || !same_vars(fa.arguments, fb.arguments)
+		 || !same_vars(fa.locals, fb.locals)) {
+			return false;
+		}
+	}
+	for (auto& itr : a.user_types)
+	{
+		auto find = b.user_types.find(itr.first);
+		if (find == b.user_types.end() || !same_vars(itr.second, find->second)) {
+			return false;
+		}
+	}
+	return same_vars(a.uniforms, b.uniforms)
+		&& same_vars(a.globals, b.globals)
+		&& a.local_size_x == b.local_size_x
+		&& a.local_size_y == b.local_size_y
+		&& a.local_size_z == b.local_size_z
+		&& a.arithmetic_inst_count == b.arithmetic_inst_count
+		&& a.control_flow_inst_count == b.control_flow_inst_count;
+}
+
+template <typename Parse>
+double time_ms(Parse parse)
+{
+	// best of the runs, the others are noise from the machine
+	double best = 0;
+	for (int i = 0; i < ITERATIONS; ++i)
+	{
+		auto begin = std::chrono::steady_clock::now();
+		parse();
+		std::chrono::duration<double, std::milli> d = std::chrono::steady_clock::now() - begin;
+		if (i == 0 || d.count() < best) {
+			best = d.count();
+		}
+	}
+	return best;
+}
+
+}
+
+int main()
+{
+	const std::vector<spv_word> spv = build_module();
+
+	Module legacy, flat;
+	parse_legacy(spv, legacy);
+	Parser::Parse(shadertrans::SpirvSpan(spv), flat);
+	if (!same_module(legacy, flat)) {
+		std::cerr << "the parsers disagree\n";
+		return 1;
+	}
+
+	const double legacy_ms = time_ms([&]() {
+		Module module;
+		parse_legacy(spv, module);
+	});
+	const double flat_ms = time_ms([&]() {
+		Module module;
+		Parser::Parse(shadertrans::SpirvSpan(spv), module);
+	});
+
+	std::cout << spv.size() << " words, bound " << spv[3] << ", best of " << ITERATIONS << " parses\n"
+		<< "unordered_map + std::function: " << legacy_ms << " ms\n"
+		<< "IdTables:                      " << flat_ms << " ms\n"
+		<< "speedup:                       " << legacy_ms / flat_ms << "x\n";
+
+	return 0;
+}
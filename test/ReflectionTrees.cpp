@@ -0,0 +1,245 @@
+// spirv::Reflection must produce the same Variable trees as the SPIRV-Cross
+// based ShaderReflection, see spirv_Reflection.h
+
+#include "shadertrans/ShaderTrans.h"
+#include "shadertrans/ShaderReflection.h"
+#include "shadertrans/spirv_Reflection.h"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+struct Case
+{
+	const char* name;
+	shadertrans::ShaderStage stage;
+	const char* glsl;
+	std::vector<const char*> functions;
+};
+
+const Case CASES[] = {
+	{ "nested structs and arrays", shadertrans::ShaderStage::PixelShader, R"(
+#version 450
+struct Light
+{
+	vec3 pos;
+	float radius;
+	vec4 color[2];
+};
+struct Material
+{
+	Light lights[3];
+	mat4 model;
+	float weights[4];
+	ivec2 flags;
+};
+layout(std140, binding = 0) uniform Scene
+{
+	Material mtl;
+	Light sun;
+	float exposure[3];
+	mat3 normal_mat;
+	vec2 grid[3][4];
+	Light cells[2][3];
+} u_scene;
+layout(binding = 1) uniform sampler2D u_tex;
+layout(location = 0) in vec2 v_uv;
+layout(location = 0) out vec4 frag_color;
+vec4 shade(vec4 base, float k, Light l)
+{
+	return base * k * l.radius;
+}
+void main()
+{
+	vec4 c = texture(u_tex, v_uv) * u_scene.exposure[1];
+	c += u_scene.mtl.lights[2].color[1] * u_scene.mtl.weights[3];
+	c += u_scene.mtl.model[0] * float(u_scene.mtl.flags.x);
+	c.xyz += u_scene.normal_mat[1];
+	c.xy += u_scene.grid[2][3] + u_scene.cells[1][2].color[0].zw;
+	frag_color = shade(c, 0.5, u_scene.sun);
+}
+)", { "shade", "main" } },
+
+	{ "unnamed block and samplers", shadertrans::ShaderStage::PixelShader, R"(
+#version 450
+layout(std140, binding = 0) uniform Params
+{
+	float time;
+	vec2 resolution;
+	vec4 tint[2];
+};
+layout(binding = 1) uniform sampler2D u_color;
+layout(binding = 2) uniform samplerCube u_env;
+layout(location = 0) in vec3 v_dir;
+layout(location = 0) out vec4 frag_color;
+void main()
+{
+	frag_color = texture(u_color, v_dir.xy * resolution) * time
+		+ texture(u_env, v_dir) * tint[1];
+}
+)", { "main" } },
+
+	{ "storage buffers", shadertrans::ShaderStage::ComputeShader, R"(
+#version 450
+layout(local_size_x = 64) in;
+struct Particle
+{
+	vec4 pos;
+	vec4 vel;
+	float life;
+};
+layout(std430, binding = 0) buffer Particles
+{
+	uint count;
+	Particle items[];
+} b_particles;
+layout(std430, binding = 1) buffer Weights
+{
+	float values[16];
+} b_weights;
+layout(std140, binding = 2) uniform Sim
+{
+	float dt;
+	vec3 gravity;
+} u_sim;
+float decay(float life, float dt)
+{
+	return max(life - dt, 0.0);
+}
+void main()
+{
+	uint i = gl_GlobalInvocationID.x;
+	if (i >= b_particles.count) {
+		return;
+	}
+	b_particles.items[i].vel.xyz += u_sim.gravity * u_sim.dt * b_weights.values[i % 16];
+	b_particles.items[i].pos += b_particles.items[i].vel * u_sim.dt;
+	b_particles.items[i].life = decay(b_particles.items[i].life, u_sim.dt);
+}
+)", { "decay", "main" } },
+};
+
+void dump(const shadertrans::ShaderReflection::Variable& var, std::ostream& out, int depth = 0)
+{
+	out << std::string(depth * 2, ' ') << '"' << var.name << "\" type " << static_cast<int>(var.type)
+		<< " binding " << var.binding << " offset " << var.offset << " size " << var.size
+		<< " array_stride " << var.array_stride << " matrix_stride " << var.matrix_stride
+		<< " array_size " << var.array_size << '\n';
+	for (auto& child : var.children) {
+		dump(child, out, depth + 1);
+	}
+}
+
+std::string dump(const std::vector<shadertrans::ShaderReflection::Variable>& vars)
+{
+	std::ostringstream out;
+	for (auto& var : vars) {
+		dump(var, out);
+	}
+	return out.str();
+}
+
+std::string dump(const shadertrans::ShaderReflection::Function& func)
+{
+	std::ostringstream out;
+	dump(func.ret_type, out);
+	for (auto& arg : func.arguments) {
+		dump(arg, out, 1);
+	}
+	return out.str();
+}
+
+// an Array spans array_size elements of array_stride bytes, arrays of
+// arrays included
+bool check_arrays(const shadertrans::ShaderReflection::Variable& var)
+{
+	if (var.type == shadertrans::ShaderReflection::VarType::Array && var.array_size != 0
+	 && var.array_size * var.array_stride != var.size) {
+		std::cerr << var.name << ": array_size " << var.array_size << " * array_stride "
+			<< var.array_stride << " != size " << var.size << '\n';
+		return false;
+	}
+	for (auto& child : var.children) {
+		if (!check_arrays(child)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool compare(const char* what, const std::string& expected, const std::string& actual)
+{
+	if (expected == actual) {
+		return true;
+	}
+
+	std::cerr << what << " differ\nShaderReflection:\n" << expected
+		<< "spirv::Reflection:\n" << actual;
+	return false;
+}
+
+}
+
+int main()
+{
+	using namespace shadertrans;
+
+	int failures = 0;
+	for (auto& c : CASES)
+	{
+		std::ostringstream log;
+		std::vector<unsigned int> spirv;
+		ShaderTrans::GLSL2SpirV(c.stage, c.glsl, nullptr, spirv, false, log);
+		if (spirv.empty()) {
+			++failures;
+			std::cerr << c.name << ": compile failed\n" << log.str();
+			continue;
+		}
+
+		for (bool compact : { false, true })
+		{
+			std::vector<ShaderReflection::Variable> expected, actual;
+			ShaderReflection::GetUniforms(spirv, expected, compact);
+			spirv::Reflection::GetUniforms(spirv, actual, compact);
+
+			const std::string what = std::string(c.name) + (compact ? ": compact uniforms" : ": uniforms");
+			if (expected.empty()) {
+				++failures;
+				std::cerr << what << " are empty\n";
+			} else if (!compare(what.c_str(), dump(expected), dump(actual))) {
+				++failures;
+			}
+
+			for (auto& var : expected) {
+				if (!check_arrays(var)) {
+					++failures;
+				}
+			}
+		}
+
+		for (auto& name : c.functions)
+		{
+			ShaderReflection::Function expected, actual;
+			const bool found_expected = ShaderReflection::GetFunction(spirv, name, expected);
+			const bool found_actual = spirv::Reflection::GetFunction(spirv, name, actual);
+
+			const std::string what = std::string(c.name) + ": function " + name;
+			if (!found_expected || !found_actual) {
+				++failures;
+				std::cerr << what << " not found\n";
+			} else if (!compare(what.c_str(), dump(expected), dump(actual))) {
+				++failures;
+			}
+		}
+	}
+
+	if (failures > 0) {
+		std::cerr << failures << " failures\n";
+		return 1;
+	}
+	return 0;
+}